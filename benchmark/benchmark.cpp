@@ -0,0 +1,292 @@
+/**
+ *  Benchmark.cpp
+ *
+ *  Benchmarks of the parsers, the processors (with a BarMaker) and the
+ *  printer, over a synthetic tape (made by the Generator) that is the same
+ *  on every run. For every benchmark the events per second, the nanoseconds
+ *  per event and the bytes allocated are reported, this is the baseline to
+ *  measure changes against.
+ *
+ *  Usage: benchmark [events] [seed] [filter]
+ *
+ *  @author Michael van der Werve
+ */
+
+#include <streambar.h>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <functional>
+
+/**
+ *  The allocations, counted by the replaced operators below
+ */
+static std::atomic<size_t> allocations{0};
+static std::atomic<size_t> allocated{0};
+
+/**
+ *  Count every allocation, it is not inlined either (see below)
+ *  @param  size
+ *  @return void*
+ */
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    // count it
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated.fetch_add(size, std::memory_order_relaxed);
+
+    // and allocate it
+    void *result = malloc(size == 0 ? 1 : size);
+    if (result == nullptr) throw std::bad_alloc();
+    return result;
+}
+
+/**
+ *  Release an allocation, it is not inlined into the callers, where the
+ *  compiler would see free() on memory from operator new
+ *  @param  pointer
+ */
+__attribute__((noinline)) void operator delete(void *pointer) noexcept
+{
+    // it came from malloc
+    free(pointer);
+}
+
+/**
+ *  The other forms go through the two above
+ */
+void *operator new[](size_t size) { return ::operator new(size); }
+void operator delete[](void *pointer) noexcept { ::operator delete(pointer); }
+void operator delete(void *pointer, size_t) noexcept { ::operator delete(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { ::operator delete(pointer); }
+
+/**
+ *  Event processor that only counts the events
+ */
+class Counter : public EventProcessor
+{
+public:
+    /**
+     *  Number of events
+     */
+    size_t events = 0;
+
+    /**
+     *  Count the events
+     *  @param  quote
+     */
+    virtual void onTrade(const Quote &trade) override { events++; }
+    virtual void onBid(const Quote &bid) override { events++; }
+    virtual void onAsk(const Quote &ask) override { events++; }
+};
+
+/**
+ *  Bar handler that only counts the bars, or keeps them
+ */
+class Collector : public Bar::Handler
+{
+public:
+    /**
+     *  Number of bars, and the bars if they are kept
+     */
+    size_t count = 0;
+    bool keep = false;
+    std::vector<std::shared_ptr<Bar>> bars;
+
+    /**
+     *  Called when a bar is done
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // count it, and keep it if we should
+        count++;
+        if (keep) bars.push_back(bar);
+    }
+};
+
+/**
+ *  Stream buffer that drops everything
+ */
+class Discard : public std::streambuf
+{
+protected:
+    /**
+     *  Take the characters
+     */
+    virtual int overflow(int c) override { return c; }
+    virtual std::streamsize xsputn(const char *data, std::streamsize size) override { return size; }
+};
+
+/**
+ *  Event processor that keeps the events
+ */
+class Recorder : public EventProcessor
+{
+public:
+    /**
+     *  An event
+     */
+    struct Event
+    {
+        uint8_t type;
+        Quote quote;
+    };
+
+    /**
+     *  The events
+     */
+    std::vector<Event> events;
+
+    /**
+     *  Keep the events
+     *  @param  quote
+     */
+    virtual void onTrade(const Quote &trade) override { events.push_back({ 1, trade }); }
+    virtual void onBid(const Quote &bid) override { events.push_back({ 2, bid }); }
+    virtual void onAsk(const Quote &ask) override { events.push_back({ 3, ask }); }
+};
+
+/**
+ *  Run a benchmark, and report it
+ *  @param  name
+ *  @param  function    returns the number of events it processed
+ */
+static void measure(const char *name, const std::function<size_t()> &function)
+{
+    // the allocations before
+    size_t count = allocations.load();
+    size_t bytes = allocated.load();
+
+    // run it
+    auto start = std::chrono::steady_clock::now();
+    size_t events = function();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the allocations during the run
+    count = allocations.load() - count;
+    bytes = allocated.load() - bytes;
+
+    // report it
+    printf("%-26s %12zu %14.0f %10.1f %14zu %10.1f %12zu\n", name, events, events / seconds, seconds * 1e9 / events, bytes, double(bytes) / events, count);
+}
+
+/**
+ *  Main procedure
+ *  @param  argc
+ *  @param  argv
+ *  @return int
+ */
+int main(int argc, const char *argv[])
+{
+    // the number of events, the seed, and the benchmarks to run
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+    std::string filter = argc > 3 ? argv[3] : "";
+    if (count == 0) { fprintf(stderr, "usage: %s [events] [seed] [filter]\n", argv[0]); return 1; }
+
+    // the events, in both formats, and parsed
+    Generator::Params params;
+    params.events = count;
+    params.seed = seed;
+    std::string tape = Generator(params).text(TapeIndex::Tape);
+    std::string mml = Generator(params).text(TapeIndex::Mml);
+    Recorder recorder;
+    recorder.events.reserve(count);
+    Generator(params).run(recorder);
+    const auto &events = recorder.events;
+
+    // whether a benchmark should run
+    auto selected = [&filter](const std::string &name) { return name.find(filter) != std::string::npos; };
+
+    // the header
+    printf("%zu events (tape %.1f MB, mml %.1f MB), seed %llu\n\n", count, tape.size() / 1e6, mml.size() / 1e6, (unsigned long long)seed);
+    printf("%-26s %12s %14s %10s %14s %10s %12s\n", "benchmark", "events", "events/sec", "ns/event", "bytes", "bytes/event", "allocations");
+
+    // the generator itself
+    if (selected("Generator")) measure("Generator/tape", [&]() { Generator(params).text(TapeIndex::Tape); return count; });
+    if (selected("Generator")) measure("Generator/mml", [&]() { Generator(params).text(TapeIndex::Mml); return count; });
+
+    // the parsers, the events go nowhere (the streams are made up front, they copy the input)
+    std::istringstream tapeStream(tape), mmlStream(mml);
+    Counter counter;
+    if (selected("processTape")) measure("processTape", [&]() { counter.events = 0; Util::processTape(counter, tapeStream); return counter.events; });
+
+    // only the events that pass the filter are counted, and what it says about the others is discarded
+    if (selected("process")) measure("process", [&]() {
+        Discard discard;
+        std::streambuf *previous = std::cout.rdbuf(&discard);
+        counter.events = 0;
+        Util::process(counter, mmlStream);
+        std::cout.rdbuf(previous);
+        return counter.events;
+    });
+
+    // every processor, with a bar maker, on the parsed events
+    std::vector<BarSpec> specs = {
+        BarSpec("tick", 100), BarSpec("volume", 25000), BarSpec("time", 60), BarSpec("change", 10), BarSpec("bachange", 10),
+        BarSpec("bichange", 10), BarSpec("dollar", 2500000), BarSpec("tickimbalance", 100), BarSpec("volumeimbalance", 100),
+        BarSpec("dollarimbalance", 100), BarSpec("tickruns", 100), BarSpec("volumeruns", 100), BarSpec("dollarruns", 100)
+    };
+    for (const auto &spec : specs)
+    {
+        // the name of the benchmark
+        std::string name = "BarMaker/" + spec.type();
+        if (!selected(name)) continue;
+
+        // the bars are only counted
+        Collector collector;
+        auto processor = spec.create();
+        measure(name.c_str(), [&]() {
+            BarMaker maker(&collector, processor.get());
+            for (const auto &event : events) Util::dispatch(maker, event.type, event.quote, "");
+            maker.flush();
+            return events.size();
+        });
+    }
+
+    // the printer, on the bars of the tick processor
+    if (selected("BarPrinter"))
+    {
+        // make the bars first
+        Collector collector;
+        collector.keep = true;
+        TickBarProcessor processor(10);
+        {
+            BarMaker maker(&collector, &processor);
+            for (const auto &event : events) Util::dispatch(maker, event.type, event.quote, "");
+        }
+
+        // print them, the output is discarded
+        Discard discard;
+        std::ostream stream(&discard);
+        BarPrinter printer(stream);
+        measure("BarPrinter::onBar", [&]() {
+            for (const auto &bar : collector.bars) printer.onBar(bar);
+            return collector.bars.size();
+        });
+    }
+
+    // the stages, when the instrumentation is compiled in
+    if (Instrumentation::enabled)
+    {
+        // over all benchmarks together, in nanoseconds
+        Instrumentation total = Instrumentation::total();
+        double scale = 1.0 / Instrumentation::ticksPerNanosecond();
+        printf("\n%-26s %12s %10s %10s %10s %10s\n", "stage", "count", "p50", "p99", "p999", "max");
+        for (size_t i = 0; i < Instrumentation::Stages; i++)
+        {
+            const Histogram &histogram = total.stages[i];
+            printf("%-26s %12llu %10.0f %10.0f %10.0f %10.0f\n", Instrumentation::name(i), (unsigned long long)histogram.count(), scale * histogram.percentile(0.5), scale * histogram.percentile(0.99), scale * histogram.percentile(0.999), scale * histogram.max());
+        }
+    }
+
+    // done
+    return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ *  Column.h
+ *
+ *  Python object that exposes a column of C++-owned memory through the
+ *  buffer protocol. The column keeps the owner of the memory alive, so
+ *  numpy can wrap the column without copying the data.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/**
+ *  Buffer protocol format character for every supported element type
+ */
+template <typename T> struct ColumnFormat;
+template <> struct ColumnFormat<float>              { static constexpr const char *value = "f"; };
+template <> struct ColumnFormat<double>             { static constexpr const char *value = "d"; };
+template <> struct ColumnFormat<int8_t>             { static constexpr const char *value = "b"; };
+template <> struct ColumnFormat<uint8_t>            { static constexpr const char *value = "B"; };
+template <> struct ColumnFormat<int32_t>            { static constexpr const char *value = "i"; };
+template <> struct ColumnFormat<uint32_t>           { static constexpr const char *value = "I"; };
+template <> struct ColumnFormat<long>               { static constexpr const char *value = "l"; };
+template <> struct ColumnFormat<unsigned long>      { static constexpr const char *value = "L"; };
+template <> struct ColumnFormat<long long>          { static constexpr const char *value = "q"; };
+template <> struct ColumnFormat<unsigned long long> { static constexpr const char *value = "Q"; };
+
+/**
+ *  The python object
+ */
+struct Column
+{
+    PyObject_HEAD
+
+    /**
+     *  Owner of the memory, keeps it alive for as long as the column lives
+     */
+    std::shared_ptr<const void> owner;
+
+    /**
+     *  The memory itself
+     */
+    void *data;
+
+    /**
+     *  Number of elements and the size of a single element
+     */
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+
+    /**
+     *  Format of a single element
+     */
+    const char *format;
+};
+
+/**
+ *  Deallocate the column, releases the owner
+ *  @param  self
+ */
+static void column_dealloc(Column *self)
+{
+    // destruct the c++ member, the memory is allocated by python
+    self->owner.~shared_ptr();
+
+    // free the object
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+/**
+ *  Fill a buffer view for the column
+ *  @param  self
+ *  @param  view
+ *  @param  flags
+ */
+static int column_getbuffer(Column *self, Py_buffer *view, int flags)
+{
+    // the shape and stride have to outlive the call, so we point into the object
+    view->obj = reinterpret_cast<PyObject*>(self);
+    view->buf = self->data;
+    view->len = self->length * self->itemsize;
+    view->readonly = 0;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->length : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->itemsize : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+
+    // the view holds a reference to the column
+    Py_INCREF(self);
+
+    // success
+    return 0;
+}
+
+/**
+ *  Buffer procedures of the column
+ */
+static PyBufferProcs column_buffer = { (getbufferproc)column_getbuffer, nullptr };
+
+/**
+ *  Length of the column
+ *  @param  self
+ */
+static Py_ssize_t column_length(Column *self) { return self->length; }
+
+/**
+ *  Sequence methods, only the length is exposed, use numpy for anything else
+ */
+static PySequenceMethods column_sequence = { (lenfunc)column_length };
+
+/**
+ *  The column type
+ */
+static PyTypeObject ColumnType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "_streambar.Column",
+};
+
+/**
+ *  Initialize the column type, called once when the module is loaded
+ *  @return bool
+ */
+static bool column_ready()
+{
+    ColumnType.tp_basicsize = sizeof(Column);
+    ColumnType.tp_dealloc = (destructor)column_dealloc;
+    ColumnType.tp_as_buffer = &column_buffer;
+    ColumnType.tp_as_sequence = &column_sequence;
+    ColumnType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ColumnType.tp_doc = "Column of C++-owned memory, exposed through the buffer protocol.";
+    return PyType_Ready(&ColumnType) == 0;
+}
+
+/**
+ *  Wrap a vector that is kept alive by the owner in a numpy array, without copying
+ *  @param  owner
+ *  @param  vector
+ *  @return PyObject*
+ */
+template <typename T>
+static PyObject *column_array(const std::shared_ptr<const void> &owner, const std::vector<T> &vector)
+{
+    // numpy is only needed once we hand out arrays
+    static PyObject *numpy = nullptr;
+    if (numpy == nullptr && (numpy = PyImport_ImportModule("numpy")) == nullptr) return nullptr;
+
+    // construct the column
+    Column *column = PyObject_New(Column, &ColumnType);
+    if (column == nullptr) return nullptr;
+
+    // python does not run constructors, so placement new the owner
+    new (&column->owner) std::shared_ptr<const void>(owner);
+    column->data = vector.empty() ? static_cast<void*>(&column->length) : const_cast<T*>(vector.data());
+    column->length = vector.size();
+    column->itemsize = sizeof(T);
+    column->format = ColumnFormat<T>::value;
+
+    // numpy wraps the buffer, and keeps the column alive as its base
+    PyObject *array = PyObject_CallMethod(numpy, "asarray", "O", column);
+
+    // the array holds the reference now
+    Py_DECREF(column);
+
+    // return the array
+    return array;
+}
+
+/**
+ *  Turn all columns of a columnar handler into a dictionary of numpy arrays
+ *  @param  columns
+ *  @return PyObject*
+ */
+template <typename Columns>
+static PyObject *column_dict(const std::shared_ptr<Columns> &columns)
+{
+    // the result dictionary
+    PyObject *result = PyDict_New();
+    if (result == nullptr) return nullptr;
+
+    // the owner of the memory
+    std::shared_ptr<const void> owner = columns;
+
+    // whether all arrays were created
+    bool success = true;
+
+    // visit all the columns
+    columns->visit([&](const char *name, const auto &vector) {
+        // skip if we already failed
+        if (!success) return;
+
+        // create the array
+        PyObject *array = column_array(owner, vector);
+
+        // store it in the dictionary
+        success = array != nullptr && PyDict_SetItemString(result, name, array) == 0;
+
+        // dictionary holds the reference
+        Py_XDECREF(array);
+    });
+
+    // if we failed, we release the dictionary
+    if (!success) { Py_DECREF(result); return nullptr; }
+
+    // return the dictionary
+    return result;
+}
@@ -0,0 +1,215 @@
+/**
+ *  Events.h
+ *
+ *  Access to events that are stored in numpy arrays (or anything else
+ *  that supports the buffer protocol), either one array per field or a
+ *  single structured array. The events are fed to an event processor in
+ *  a tight loop, without touching python for every event.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <streambar.h>
+
+/**
+ *  A single one-dimensional (possibly strided) array of numbers
+ */
+class Values
+{
+private:
+    /**
+     *  The view on the buffer
+     */
+    Py_buffer _view;
+
+    /**
+     *  Format of the elements, without the byte order
+     */
+    char _format;
+
+    /**
+     *  Stride between two elements, in bytes
+     */
+    Py_ssize_t _stride;
+
+    /**
+     *  Acquire the view on the buffer
+     *  @param  object      object supporting the buffer protocol
+     *  @param  name        name of the field, used in errors
+     *  @throws std::runtime_error
+     */
+    void acquire(PyObject *object, const char *name)
+    {
+        // get a (possibly strided) view, so fields of structured arrays work too
+        if (object == nullptr || PyObject_GetBuffer(object, &_view, PyBUF_RECORDS_RO) != 0) throw std::runtime_error(std::string("Invalid events, expected array for ") + name);
+
+        // skip the native byte order markers
+        const char *format = _view.format == nullptr ? "B" : _view.format;
+        if (*format == '@' || *format == '=' || *format == '<') ++format;
+
+        // remember the format and the stride
+        _format = format[0];
+        _stride = _view.ndim == 1 ? _view.strides[0] : 0;
+
+        // only one dimensional arrays of numbers are supported
+        if (_view.ndim == 1 && format[1] == 0 && strchr("?bBhHiIlLqQfd", _format) != nullptr) return;
+
+        // release the view, the destructor is not called
+        PyBuffer_Release(&_view);
+
+        // report the error
+        throw std::runtime_error(std::string("Invalid events, expected one dimensional numeric array for ") + name);
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  object      object supporting the buffer protocol
+     *  @param  name        name of the field, used in errors
+     *  @throws std::runtime_error
+     */
+    Values(PyObject *object, const char *name)
+    {
+        // acquire the view
+        acquire(object, name);
+    }
+
+    /**
+     *  Constructor for a field of a structured array
+     *  @param  records     the structured array
+     *  @param  name        name of the field
+     *  @param  alternative alternative name of the field
+     *  @throws std::runtime_error
+     */
+    Values(PyObject *records, const char *name, const char *alternative)
+    {
+        // look up the field, the alternative name is tried if it does not exist
+        PyObject *field = PyMapping_GetItemString(records, name);
+        if (field == nullptr && alternative != nullptr) { PyErr_Clear(); field = PyMapping_GetItemString(records, alternative); }
+
+        // the view keeps the field alive, so we can release it afterwards
+        try { acquire(field, name); } catch (...) { Py_XDECREF(field); throw; }
+        Py_DECREF(field);
+    }
+
+    /**
+     *  No copying
+     */
+    Values(const Values &that) = delete;
+
+    /**
+     *  Destructor
+     */
+    virtual ~Values() { PyBuffer_Release(&_view); }
+
+    /**
+     *  Number of elements
+     *  @return size_t
+     */
+    size_t size() const { return _view.shape[0]; }
+
+    /**
+     *  Get an element, converted to the requested type
+     *  @param  index
+     *  @return T
+     */
+    template <typename T>
+    T get(size_t index) const
+    {
+        // the element itself
+        const void *data = static_cast<const char*>(_view.buf) + index * _stride;
+
+        // check the format
+        switch (_format) {
+        case '?':   return static_cast<T>(*static_cast<const bool*>(data));
+        case 'b':   return static_cast<T>(*static_cast<const int8_t*>(data));
+        case 'B':   return static_cast<T>(*static_cast<const uint8_t*>(data));
+        case 'h':   return static_cast<T>(*static_cast<const int16_t*>(data));
+        case 'H':   return static_cast<T>(*static_cast<const uint16_t*>(data));
+        case 'i':   return static_cast<T>(*static_cast<const int32_t*>(data));
+        case 'I':   return static_cast<T>(*static_cast<const uint32_t*>(data));
+        case 'l':   return static_cast<T>(*static_cast<const long*>(data));
+        case 'L':   return static_cast<T>(*static_cast<const unsigned long*>(data));
+        case 'q':   return static_cast<T>(*static_cast<const long long*>(data));
+        case 'Q':   return static_cast<T>(*static_cast<const unsigned long long*>(data));
+        case 'f':   return static_cast<T>(*static_cast<const float*>(data));
+        default:    return static_cast<T>(*static_cast<const double*>(data));
+        }
+    }
+};
+
+/**
+ *  All the fields of the events
+ */
+class Events
+{
+private:
+    /**
+     *  The record type (1 = trade, 2 = bid, 3 = ask), time, price and size
+     */
+    Values _type;
+    Values _time;
+    Values _price;
+    Values _size;
+
+public:
+    /**
+     *  Constructor
+     *  @param  type
+     *  @param  time
+     *  @param  price
+     *  @param  size
+     *  @throws std::runtime_error
+     */
+    Events(PyObject *type, PyObject *time, PyObject *price, PyObject *size) :
+        _type(type, "type"), _time(time, "time"), _price(price, "price"), _size(size, "size")
+    {
+        // all arrays should be just as long
+        if (_time.size() != _type.size() || _price.size() != _type.size() || _size.size() != _type.size()) throw std::runtime_error("Invalid events, expected arrays of equal length");
+    }
+
+    /**
+     *  Constructor for a structured array, with type (or event), time, price and size fields
+     *  @param  records
+     *  @throws std::runtime_error
+     */
+    Events(PyObject *records) :
+        _type(records, "type", "event"), _time(records, "time", nullptr), _price(records, "price", nullptr), _size(records, "size", nullptr) {}
+
+    /**
+     *  Number of events
+     *  @return size_t
+     */
+    size_t size() const { return _type.size(); }
+
+    /**
+     *  Feed all the events to a processor, unknown record types are ignored
+     *  @param  processor
+     */
+    void process(EventProcessor &processor) const
+    {
+        // the number of events
+        size_t count = size();
+
+        // iterate over the events
+        for (size_t i = 0; i < count; i++)
+        {
+            // construct the quote
+            Quote quote(_time.get<size_t>(i), _price.get<float>(i), _size.get<size_t>(i));
+
+            // switch over the type
+            switch (_type.get<int>(i)) {
+            case 1:     processor.onTrade(quote); break;
+            case 2:     processor.onBid(quote); break;
+            case 3:     processor.onAsk(quote); break;
+            case 4:     processor.onTime(quote.time()); break;
+            }
+        }
+    }
+};
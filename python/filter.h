@@ -0,0 +1,109 @@
+/**
+ *  Filter.h
+ *
+ *  Conversion of python filter specifications into a Filter, and of the
+ *  counters of a filter back into a dictionary.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <streambar.h>
+
+/**
+ *  Parse a list of numbers from a dictionary, if it is there
+ *  @param  object
+ *  @param  name
+ *  @param  numbers
+ */
+static void filternumbers(PyObject *object, const char *name, std::vector<unsigned> &numbers)
+{
+    // the list, it is optional
+    PyObject *list = PyDict_GetItemString(object, name);
+    if (list == nullptr) return;
+
+    // it must be a sequence
+    PyObject *sequence = PySequence_Fast(list, "expected a list of numbers");
+    if (sequence == nullptr) throw std::runtime_error("Invalid filter, expected " + std::string(name) + ":list");
+
+    // it replaces what was there
+    numbers.clear();
+
+    // take all the numbers
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++)
+    {
+        // the number
+        long number = PyLong_AsLong(PySequence_Fast_GET_ITEM(sequence, i));
+        if (number < 0) { Py_DECREF(sequence); throw std::runtime_error("Invalid filter, expected " + std::string(name) + " to hold non-negative integers"); }
+
+        // add it
+        numbers.push_back(number);
+    }
+
+    // done with the sequence
+    Py_DECREF(sequence);
+}
+
+/**
+ *  Parse a rule, on top of another rule
+ *  @param  object
+ *  @param  base
+ *  @return Filter::Rule
+ */
+static Filter::Rule filterrule(PyObject *object, const Filter::Rule &base)
+{
+    // start from the base
+    Filter::Rule rule = base;
+
+    // without a dictionary, it is simply the base
+    if (object == nullptr) return rule;
+    if (!PyDict_Check(object)) throw std::runtime_error("Invalid filter, expected rules to be a dict");
+
+    // parse the lists
+    filternumbers(object, "conditions", rule.conditions);
+    filternumbers(object, "exchanges", rule.exchanges);
+    filternumbers(object, "blocked", rule.blocked);
+
+    // done
+    return rule;
+}
+
+/**
+ *  Parse a filter specification, this is None for the default filter, or a
+ *  dictionary with the lists of accepted 'conditions' and 'exchanges' and
+ *  'blocked' exchanges (any list left out accepts everything). The rule may
+ *  be overridden per record type by the 'trades', 'bids' and 'asks' keys,
+ *  that hold a dictionary with the same lists.
+ *  @param  object
+ *  @return Filter
+ */
+static Filter filterspec(PyObject *object)
+{
+    // none is the default filter
+    if (object == nullptr || object == Py_None) return Filter();
+
+    // otherwise it should be a dictionary
+    if (!PyDict_Check(object)) throw std::runtime_error("Invalid filter, expected None or dict");
+
+    // the rule for every type
+    Filter::Rule rule = filterrule(object, Filter::Rule());
+
+    // and the rules per type
+    return Filter(filterrule(PyDict_GetItemString(object, "trades"), rule), filterrule(PyDict_GetItemString(object, "bids"), rule), filterrule(PyDict_GetItemString(object, "asks"), rule));
+}
+
+/**
+ *  The counters of a filter
+ *  @param  filter
+ *  @return PyObject*
+ */
+static PyObject *filterstats(const Filter &filter)
+{
+    // the checked records, and the dropped ones per reason
+    return Py_BuildValue("{s:k,s:k,s:k}", "checked", filter.checked(), "condition", filter.dropped(Filter::Condition), "exchange", filter.dropped(Filter::Exchange));
+}
@@ -0,0 +1,279 @@
+/**
+ *  Follower.h
+ *
+ *  Python object that follows a tape (or MML) file that is still being
+ *  written. Every poll parses only what was appended since the previous
+ *  one, waiting for the file to grow if there is nothing yet, and returns
+ *  the bars that were completed by it. The state of the bars is kept
+ *  between the polls.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <memory>
+#include <chrono>
+#include <streambar.h>
+#include "column.h"
+#include "unlocked.h"
+#include "spec.h"
+#include "filter.h"
+#include "maker.h"
+
+/**
+ *  The C++ side of the object, the file and the bars made from it
+ */
+struct Following
+{
+    /**
+     *  The bars, and the file they are made from
+     */
+    Incremental bars;
+    Follow file;
+
+    /**
+     *  Constructor
+     *  @param  spec
+     *  @param  path
+     *  @param  format
+     *  @param  filter
+     *  @param  gaps
+     */
+    Following(const BarSpec &spec, const std::string &path, TapeIndex::Format format, Filter filter, bool gaps) :
+        bars(spec, 0, gaps), file(path, format, std::move(filter)) {}
+};
+
+/**
+ *  The python object
+ */
+struct Follower
+{
+    PyObject_HEAD
+
+    /**
+     *  The C++ object
+     */
+    Following *following;
+};
+
+/**
+ *  Construct the object, the file and the spec are required
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static int follower_init(Follower *self, PyObject *args, PyObject *kwargs)
+{
+    // the file and the spec are required
+    const char *path = nullptr;
+    PyObject *spec = nullptr;
+    int mml = 0;
+    int gaps = 0;
+    PyObject *filter = Py_None;
+
+    // the keywords, the format, the gaps and the filter are applicable
+    static const char* keywords[] = {"", "", "mml", "gaps", "filter", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|$ppO", const_cast<char**>(keywords), &path, &spec, &mml, &gaps, &filter)) throw std::runtime_error("Invalid arguments, expected input, spec, mml:bool, gaps:bool and filter:dict");
+
+        // (re)create the C++ object
+        delete self->following;
+        self->following = nullptr;
+        self->following = new Following(barspec(spec), path, mml ? TapeIndex::Mml : TapeIndex::Tape, filterspec(filter), gaps);
+
+        // success
+        return 0;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return -1;
+    }
+}
+
+/**
+ *  Deallocate the object
+ *  @param  self
+ */
+static void follower_dealloc(Follower *self)
+{
+    // destruct the C++ object
+    delete self->following;
+
+    // free the object
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+/**
+ *  Parse what was appended, waiting for it if there is nothing yet
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static PyObject *follower_poll(Follower *self, PyObject *args, PyObject *kwargs)
+{
+    // the time to wait, by default we do not
+    int timeout = 0;
+
+    // the keywords
+    static const char* keywords[] = {"timeout", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i", const_cast<char**>(keywords), &timeout)) throw std::runtime_error("Invalid arguments, expected timeout:int");
+
+        // must be initialized
+        if (self->following == nullptr) throw std::runtime_error("Follower is not initialized");
+
+        // the completed bars
+        std::shared_ptr<BarColumns> columns;
+
+        // the waiting and the processing do not need the GIL
+        {
+            Unlocked unlocked;
+            Following &following = *self->following;
+
+            // when we stop waiting
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout, 0));
+
+            // until there are events, or the time is over
+            while (true)
+            {
+                // parse what is there, only this needs the lock (the stats can be read while we wait)
+                {
+                    std::lock_guard<std::mutex> lock(following.bars.mutex);
+                    if (following.file.poll(following.bars.input()) > 0 || timeout == 0) break;
+                }
+
+                // the milliseconds that are left
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (timeout > 0 && left <= 0) break;
+
+                // wait for the file to change
+                following.file.wait(timeout < 0 ? -1 : static_cast<int>(left));
+            }
+
+            // take the completed bars
+            std::lock_guard<std::mutex> lock(following.bars.mutex);
+            columns = following.bars.take();
+        }
+
+        // return the completed bars
+        return column_dict(columns);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Flush the open bar
+ *  @param  self
+ */
+static PyObject *follower_flush(Follower *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->following == nullptr) { PyErr_SetString(PyExc_TypeError, "Follower is not initialized"); return nullptr; }
+
+    // the completed bars
+    std::shared_ptr<BarColumns> columns;
+
+    // flushing does not need the GIL
+    {
+        Unlocked unlocked;
+        std::lock_guard<std::mutex> lock(self->following->bars.mutex);
+
+        // flush the bar
+        self->following->bars.flush();
+
+        // take the completed bars
+        columns = self->following->bars.take();
+    }
+
+    // return the completed bars
+    return column_dict(columns);
+}
+
+/**
+ *  The counters of the file
+ *  @param  self
+ */
+static PyObject *follower_stats(Follower *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->following == nullptr) { PyErr_SetString(PyExc_TypeError, "Follower is not initialized"); return nullptr; }
+
+    // the bytes read, the bytes of a partial line, and the events
+    std::lock_guard<std::mutex> lock(self->following->bars.mutex);
+    const Follow &file = self->following->file;
+    return Py_BuildValue("{s:k,s:k,s:k}", "offset", file.offset(), "pending", file.pending(), "events", file.events());
+}
+
+/**
+ *  Methods of the object
+ */
+static PyMethodDef follower_methods[] = {
+    {
+        "poll", (PyCFunction)follower_poll, METH_VARARGS | METH_KEYWORDS,
+        "Parse what was appended to the file, if there is nothing waits for it up to timeout=milliseconds:int (-1 forever, 0 does not wait). Returns the completed bars as numpy arrays."
+    },
+    {
+        "flush", (PyCFunction)follower_flush, METH_NOARGS,
+        "Complete the open bar. Returns it as numpy arrays."
+    },
+    {
+        "stats", (PyCFunction)follower_stats, METH_NOARGS,
+        "Number of bytes read, bytes of a line that is not complete yet, and events passed on."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+/**
+ *  The follower type
+ */
+static PyTypeObject FollowerType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "_streambar.Follower",
+};
+
+/**
+ *  Initialize the follower type, called once when the module is loaded
+ *  @return bool
+ */
+static bool follower_ready()
+{
+    FollowerType.tp_basicsize = sizeof(Follower);
+    FollowerType.tp_dealloc = (destructor)follower_dealloc;
+    FollowerType.tp_flags = Py_TPFLAGS_DEFAULT;
+    FollowerType.tp_doc = "Follows a tape file that is still being written, keeping the state of the bars between polls. Follower(input, spec, mml=False, gaps=False, filter=None), spec is (type, size) or a dict with the type and parameters.";
+    FollowerType.tp_methods = follower_methods;
+    FollowerType.tp_init = (initproc)follower_init;
+    FollowerType.tp_new = PyType_GenericNew;
+    return PyType_Ready(&FollowerType) == 0;
+}
@@ -0,0 +1,601 @@
+/**
+ *  Maker.h
+ *
+ *  Python object that wraps a BarMaker and its processor, so that events
+ *  can be fed in batches while the state of the bars is kept between the
+ *  batches. Every batch returns the bars that were completed by it. With
+ *  a window, the events are first put back in time order. The clock can
+ *  be advanced without events, to close time bars at their boundary. The
+ *  state can be saved to a snapshot, and loaded into a new object, and the
+ *  averages of the processor can be kept per symbol over days in a store.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <memory>
+#include <mutex>
+#include <streambar.h>
+#include "column.h"
+#include "events.h"
+#include "unlocked.h"
+#include "spec.h"
+
+/**
+ *  The C++ side of the object
+ */
+class Incremental : public Bar::Handler
+{
+private:
+    /**
+     *  The bar, and the processor for it
+     */
+    BarSpec _spec;
+    std::unique_ptr<Processor> _processor;
+
+    /**
+     *  Columns with the bars that were completed since they were last taken
+     */
+    std::shared_ptr<BarColumns> _columns = std::make_shared<BarColumns>();
+
+    /**
+     *  The maker itself, it emits to us
+     */
+    BarMaker _maker;
+
+    /**
+     *  The reordering in front of the maker, if there is a window
+     */
+    std::unique_ptr<Reorder> _reorder;
+
+    /**
+     *  Called when a bar is fully done.
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // store it in the columns
+        _columns->onBar(bar);
+    }
+
+    /**
+     *  Read the state from a snapshot, without checking it first
+     *  @param  data
+     *  @throws std::runtime_error
+     */
+    void restore(std::string data)
+    {
+        // the maker
+        Snapshot snapshot(std::move(data));
+        _maker.load(snapshot);
+
+        // the reordering must match
+        bool reorder;
+        snapshot.read(reorder);
+        if (reorder != (_reorder != nullptr)) throw std::runtime_error("snapshot has another window");
+        if (_reorder) _reorder->load(snapshot);
+
+        // and the completed bars of before are not ours
+        take();
+    }
+
+public:
+    /**
+     *  Lock for the object, as we process without holding the GIL
+     */
+    std::mutex mutex;
+
+    /**
+     *  Constructor
+     *  @param  spec
+     *  @param  window  time window to reorder the events in, 0 for none
+     *  @param  gaps    whether the empty time boxes are emitted
+     */
+    Incremental(const BarSpec &spec, size_t window = 0, bool gaps = false) : _spec(spec), _processor(spec.create()), _maker(this, _processor.get(), gaps)
+    {
+        // reorder if there is a window
+        if (window > 0) _reorder.reset(new Reorder(&_maker, window));
+    }
+
+    /**
+     *  Where the events go
+     *  @return EventProcessor
+     */
+    EventProcessor &input() { return _reorder ? static_cast<EventProcessor&>(*_reorder) : _maker; }
+
+    /**
+     *  Pass on the held events, and complete the open bar
+     */
+    void flush()
+    {
+        // first the held events
+        if (_reorder) _reorder->flush();
+
+        // and then the bar
+        _maker.flush();
+    }
+
+    /**
+     *  Write the state of the maker and the reordering to a snapshot
+     *  @return std::string
+     */
+    std::string save() const
+    {
+        // the maker, and the reordering if there is one
+        Snapshot snapshot;
+        _maker.save(snapshot);
+        snapshot.write<bool>(_reorder != nullptr);
+        if (_reorder) _reorder->save(snapshot);
+
+        // the bytes
+        return snapshot.data();
+    }
+
+    /**
+     *  Read the state from a snapshot, the state is unchanged if it fails
+     *  @param  data
+     *  @throws std::runtime_error
+     */
+    void load(std::string data)
+    {
+        // first read it all into a new object, that throws if anything is wrong
+        Incremental(_spec, _reorder ? _reorder->window() : 0, _maker.gaps()).restore(data);
+
+        // so now it can no longer fail halfway
+        restore(std::move(data));
+    }
+
+    /**
+     *  Start the processor from the state in a store
+     *  @param  path
+     *  @param  symbol
+     *  @return bool    whether there was a state
+     *  @throws std::runtime_error
+     */
+    bool warm(const std::string &path, const std::string &symbol)
+    {
+        // load it from the store
+        return WarmStore(path).warm(symbol, _spec, *_processor);
+    }
+
+    /**
+     *  Store the state of the processor, should be after the flush at the end of the day
+     *  @param  path
+     *  @param  symbol
+     *  @throws std::runtime_error
+     */
+    void persist(const std::string &path, const std::string &symbol)
+    {
+        // put it in the store, and write it
+        WarmStore store(path);
+        store.put(symbol, _spec, *_processor);
+        store.save();
+    }
+
+    /**
+     *  The reordering, if there is a window
+     *  @return Reorder
+     */
+    const Reorder *reorder() const { return _reorder.get(); }
+
+    /**
+     *  Take the completed bars
+     *  @return std::shared_ptr<BarColumns>
+     */
+    std::shared_ptr<BarColumns> take()
+    {
+        // swap with new columns
+        auto result = std::make_shared<BarColumns>();
+        std::swap(result, _columns);
+
+        // return the completed bars
+        return result;
+    }
+};
+
+/**
+ *  The python object
+ */
+struct Maker
+{
+    PyObject_HEAD
+
+    /**
+     *  The C++ object
+     */
+    Incremental *incremental;
+};
+
+/**
+ *  Construct the object, the spec is the only argument
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static int maker_init(Maker *self, PyObject *args, PyObject *kwargs)
+{
+    // the spec is required
+    PyObject *spec = nullptr;
+    unsigned long long window = 0;
+    int gaps = 0;
+
+    // the keywords, the window and the gaps are applicable
+    static const char* keywords[] = {"", "window", "gaps", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$Kp", const_cast<char**>(keywords), &spec, &window, &gaps)) throw std::runtime_error("Invalid arguments, expected spec, window:int and gaps:bool");
+
+        // (re)create the C++ object
+        delete self->incremental;
+        self->incremental = nullptr;
+        self->incremental = new Incremental(barspec(spec), window, gaps);
+
+        // success
+        return 0;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return -1;
+    }
+}
+
+/**
+ *  Deallocate the object
+ *  @param  self
+ */
+static void maker_dealloc(Maker *self)
+{
+    // destruct the C++ object
+    delete self->incremental;
+
+    // free the object
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+/**
+ *  Process a batch of events
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static PyObject *maker_process(Maker *self, PyObject *args, PyObject *kwargs)
+{
+    // all the arrays are required
+    PyObject *type, *time, *price, *size;
+
+    // the keywords
+    static const char* keywords[] = {"", "", "", "", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO", const_cast<char**>(keywords), &type, &time, &price, &size)) throw std::runtime_error("Invalid arguments, expected type, time, price and size arrays");
+
+        // must be initialized
+        if (self->incremental == nullptr) throw std::runtime_error("BarMaker is not initialized");
+
+        // access the events
+        Events events(type, time, price, size);
+
+        // the completed bars
+        std::shared_ptr<BarColumns> columns;
+
+        // the processing does not need the GIL
+        {
+            Unlocked unlocked;
+            std::lock_guard<std::mutex> lock(self->incremental->mutex);
+
+            // feed the events
+            events.process(self->incremental->input());
+
+            // take the completed bars
+            columns = self->incremental->take();
+        }
+
+        // return the completed bars
+        return column_dict(columns);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Advance the clock, closes the time bars that are over
+ *  @param  self
+ *  @param  args
+ */
+static PyObject *maker_clock(Maker *self, PyObject *args)
+{
+    // the time is required
+    unsigned long long time;
+    if (!PyArg_ParseTuple(args, "K", &time)) return nullptr;
+
+    // must be initialized
+    if (self->incremental == nullptr) { PyErr_SetString(PyExc_TypeError, "BarMaker is not initialized"); return nullptr; }
+
+    // the completed bars
+    std::shared_ptr<BarColumns> columns;
+
+    // the clock does not need the GIL
+    {
+        Unlocked unlocked;
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+
+        // time has passed
+        self->incremental->input().onTime(time);
+
+        // take the completed bars
+        columns = self->incremental->take();
+    }
+
+    // return the completed bars
+    return column_dict(columns);
+}
+
+/**
+ *  Flush the open bar
+ *  @param  self
+ */
+static PyObject *maker_flush(Maker *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->incremental == nullptr) { PyErr_SetString(PyExc_TypeError, "BarMaker is not initialized"); return nullptr; }
+
+    // the completed bars
+    std::shared_ptr<BarColumns> columns;
+
+    // flushing does not need the GIL
+    {
+        Unlocked unlocked;
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+
+        // flush the bar
+        self->incremental->flush();
+
+        // take the completed bars
+        columns = self->incremental->take();
+    }
+
+    // return the completed bars
+    return column_dict(columns);
+}
+
+/**
+ *  Save the state to a snapshot
+ *  @param  self
+ */
+static PyObject *maker_save(Maker *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->incremental == nullptr) { PyErr_SetString(PyExc_TypeError, "BarMaker is not initialized"); return nullptr; }
+
+    // the snapshot
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+        data = self->incremental->save();
+    }
+
+    // as bytes
+    return PyBytes_FromStringAndSize(data.data(), data.size());
+}
+
+/**
+ *  Load the state from a snapshot
+ *  @param  self
+ *  @param  args
+ */
+static PyObject *maker_load(Maker *self, PyObject *args)
+{
+    // the snapshot is required, as bytes
+    PyObject *bytes;
+    if (!PyArg_ParseTuple(args, "O!", &PyBytes_Type, &bytes)) return nullptr;
+
+    // we may fail to load the snapshot
+    try
+    {
+        // must be initialized
+        if (self->incremental == nullptr) throw std::runtime_error("BarMaker is not initialized");
+
+        // load it
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+        self->incremental->load(std::string(PyBytes_AS_STRING(bytes), PyBytes_GET_SIZE(bytes)));
+
+        // done
+        Py_RETURN_NONE;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Start from the state of the day before, in a store
+ *  @param  self
+ *  @param  args
+ */
+static PyObject *maker_warm(Maker *self, PyObject *args)
+{
+    // the store and the symbol are required
+    const char *path, *symbol;
+    if (!PyArg_ParseTuple(args, "ss", &path, &symbol)) return nullptr;
+
+    // we may fail to read the store
+    try
+    {
+        // must be initialized
+        if (self->incremental == nullptr) throw std::runtime_error("BarMaker is not initialized");
+
+        // load the state
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+        return PyBool_FromLong(self->incremental->warm(path, symbol));
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Store the state at the end of the day
+ *  @param  self
+ *  @param  args
+ */
+static PyObject *maker_persist(Maker *self, PyObject *args)
+{
+    // the store and the symbol are required
+    const char *path, *symbol;
+    if (!PyArg_ParseTuple(args, "ss", &path, &symbol)) return nullptr;
+
+    // we may fail to write the store
+    try
+    {
+        // must be initialized
+        if (self->incremental == nullptr) throw std::runtime_error("BarMaker is not initialized");
+
+        // store the state
+        std::lock_guard<std::mutex> lock(self->incremental->mutex);
+        self->incremental->persist(path, symbol);
+
+        // done
+        Py_RETURN_NONE;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  The counters of the reordering
+ *  @param  self
+ */
+static PyObject *maker_stats(Maker *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->incremental == nullptr) { PyErr_SetString(PyExc_TypeError, "BarMaker is not initialized"); return nullptr; }
+
+    // the reordering, without a window nothing is held or dropped
+    std::lock_guard<std::mutex> lock(self->incremental->mutex);
+    const Reorder *reorder = self->incremental->reorder();
+
+    // the held, late and forced events
+    return Py_BuildValue("{s:k,s:k,s:k}", "held", reorder ? reorder->size() : 0ul, "late", reorder ? reorder->late() : 0ul, "forced", reorder ? reorder->forced() : 0ul);
+}
+
+/**
+ *  Methods of the object
+ */
+static PyMethodDef maker_methods[] = {
+    {
+        "process", (PyCFunction)maker_process, METH_VARARGS | METH_KEYWORDS,
+        "Process a batch of events, given as type, time, price and size arrays. Returns the completed bars as numpy arrays."
+    },
+    {
+        "clock", (PyCFunction)maker_clock, METH_VARARGS,
+        "Advance the clock to a time, without an event. Returns the bars that were completed by it as numpy arrays."
+    },
+    {
+        "flush", (PyCFunction)maker_flush, METH_NOARGS,
+        "Complete the open bar. Returns it as numpy arrays."
+    },
+    {
+        "save", (PyCFunction)maker_save, METH_NOARGS,
+        "Save the state (the open bar, the quotes, the tick rule, the processor and the held events) to a snapshot. Returns bytes."
+    },
+    {
+        "load", (PyCFunction)maker_load, METH_VARARGS,
+        "Load the state from a snapshot, into a BarMaker with the same spec and window."
+    },
+    {
+        "warm", (PyCFunction)maker_warm, METH_VARARGS,
+        "Start the averages of the bars from the state of the day before, in a store file, for a symbol. Returns whether there was a state."
+    },
+    {
+        "persist", (PyCFunction)maker_persist, METH_VARARGS,
+        "Store the averages of the bars for a symbol in a store file, for the next day. Should be done after the flush at the end of the day."
+    },
+    {
+        "stats", (PyCFunction)maker_stats, METH_NOARGS,
+        "Number of events that are held for reordering, that were dropped as late, and that were passed on early because the buffer was full."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+/**
+ *  The maker type
+ */
+static PyTypeObject MakerType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "_streambar.BarMaker",
+};
+
+/**
+ *  Initialize the maker type, called once when the module is loaded
+ *  @return bool
+ */
+static bool maker_ready()
+{
+    MakerType.tp_basicsize = sizeof(Maker);
+    MakerType.tp_dealloc = (destructor)maker_dealloc;
+    MakerType.tp_flags = Py_TPFLAGS_DEFAULT;
+    MakerType.tp_doc = "Incremental bar maker, keeps the state of the bars between batches of events. BarMaker(spec, window=0, gaps=False), spec is (type, size) or a dict with the type and parameters, window=milliseconds to reorder events in:int, gaps=emit the empty time boxes:bool.";
+    MakerType.tp_methods = maker_methods;
+    MakerType.tp_init = (initproc)maker_init;
+    MakerType.tp_new = PyType_GenericNew;
+    return PyType_Ready(&MakerType) == 0;
+}
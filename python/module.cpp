@@ -1,62 +1,82 @@
 #include <stdio.h>
 #include <Python.h>
 #include <streambar.h>
+#include "column.h"
+#include "unlocked.h"
+#include "spec.h"
+#include "maker.h"
+#include "filter.h"
+#include "events.h"
+#include "follower.h"
+#include "server.h"
+#include "reader.h"
 
 #include <cstring>
 #include <cerrno>
 
 /**
- *  Process it into a bar
+ *  Process it into a bar, either written to the output file (returns the number
+ *  of bars) or, without an output file, returned as a dictionary of numpy arrays
  */
-size_t convert(Processor &processor, const std::string &input, const std::string &output)
+PyObject *convert(Processor &processor, const char *input, const char *output, size_t start, size_t end, bool gaps = false)
 {
-    // open the files 
-    std::ifstream in(input);
-    if (!in.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
-
-    std::ofstream out(output, std::ios::trunc);
-    if (!out.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+    // with an output file we simply print the bars
+    if (output != nullptr)
+    {
+        // number of bars written
+        size_t numbars = 0;
 
-    // printer
-    BarPrinter printer(out);
+        // the conversion does not need the GIL
+        {
+            Unlocked unlocked;
+            numbars = Convert::run(processor, input, std::string(output), start, end, gaps);
+        }
 
-    // create the barmaker
-    BarMaker barmaker(&printer, &processor);
+        // return the number of bars
+        return PyLong_FromUnsignedLong(numbars);
+    }
 
-    // process
-    Util::processTape(barmaker, in);
+    // the columns are shared with the arrays we hand out
+    auto columns = std::make_shared<BarColumns>();
 
-    // flush the barmaker
-    barmaker.flush();
+    // convert into the columns, the GIL is only needed for the arrays
+    {
+        Unlocked unlocked;
+        Convert::run(processor, *columns, input, start, end, gaps);
+    }
 
-    // return number of bars
-    return printer.number();
+    // wrap the columns
+    return column_dict(columns);
 }
 
 template <class P>
 static PyObject* sizedbar(PyObject *self, PyObject *args, PyObject* kwargs) {
     // input and output are both required
     const char *input;
-    const char *output;
+    const char *output = nullptr;
     int size = 100;
 
-    // number of bars written
-    size_t numbars = 0;
+    // the time range, everything by default
+    unsigned long long start = 0;
+    unsigned long long end = SIZE_MAX;
 
-    // the keywords, only size is applicable
-    static const char* keywords[] = {"", "", "size", NULL};
+    // whether the empty time boxes are emitted
+    int gaps = 0;
+
+    // the keywords, size, the time range and the gaps are applicable
+    static const char* keywords[] = {"", "", "size", "start", "end", "gaps", NULL};
 
     // we may fail to parse the keywords, or something else might go wrong
     try
     {
         // allow the arguments
-        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ss$i", const_cast<char**>(keywords), &input, &output, &size)) throw std::runtime_error("Invalid arguments, expected size:int");
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|z$iKKp", const_cast<char**>(keywords), &input, &output, &size, &start, &end, &gaps)) throw std::runtime_error("Invalid arguments, expected size:int, start:int, end:int and gaps:bool");
 
         // make the bar processor
         P processor(size);
 
         // open the files
-        numbars = convert(processor, input, output);
+        return convert(processor, input, output, start, end, gaps);
     }
 
     // catch the runtime error we might have thrown
@@ -71,34 +91,32 @@ static PyObject* sizedbar(PyObject *self, PyObject *args, PyObject* kwargs) {
         // failed
         return nullptr;
     }
-
-    //printf("Hello, %s!\n", name);
-    return PyLong_FromUnsignedLong(numbars);
 }
 
 static PyObject* dollarbar(PyObject *self, PyObject *args, PyObject* kwargs) {
     // input and output are both required
     const char *input;
-    const char *output;
+    const char *output = nullptr;
     float size = 100;
 
-    // number of bars written
-    size_t numbars = 0;
+    // the time range, everything by default
+    unsigned long long start = 0;
+    unsigned long long end = SIZE_MAX;
 
-    // the keywords, only size is applicable
-    static const char* keywords[] = {"", "", "size", NULL};
+    // the keywords, size and the time range are applicable
+    static const char* keywords[] = {"", "", "size", "start", "end", NULL};
 
     // we may fail to parse the keywords, or something else might go wrong
     try
     {
         // allow the arguments
-        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ss$f", const_cast<char**>(keywords), &input, &output, &size)) throw std::runtime_error("Invalid arguments, expected size:float");
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|z$fKK", const_cast<char**>(keywords), &input, &output, &size, &start, &end)) throw std::runtime_error("Invalid arguments, expected size:float, start:int and end:int");
 
         // make the bar processor
         DollarBarProcessor processor(size);
 
         // open the files
-        numbars = convert(processor, input, output);
+        return convert(processor, input, output, start, end);
     }
 
     // catch the runtime error we might have thrown
@@ -113,47 +131,921 @@ static PyObject* dollarbar(PyObject *self, PyObject *args, PyObject* kwargs) {
         // failed
         return nullptr;
     }
+}
 
-    //printf("Hello, %s!\n", name);
-    return PyLong_FromUnsignedLong(numbars);
+static PyObject* resample(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the bars and the size are required
+    PyObject *bars = nullptr;
+    unsigned long long size = 0;
+    const char *by = "count";
+
+    // the keywords, only the grouping is applicable
+    static const char* keywords[] = {"", "", "by", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OK|$s", const_cast<char**>(keywords), &bars, &size, &by)) throw std::runtime_error("Invalid arguments, expected bars:dict, size:int and by:str");
+
+        // the grouping
+        if (strcmp(by, "count") != 0 && strcmp(by, "time") != 0) throw std::runtime_error("Invalid arguments, expected by to be 'count' or 'time'");
+        Resample::Mode mode = strcmp(by, "count") == 0 ? Resample::Count : Resample::Time;
+
+        // all the columns of the bars
+        Values open(bars, "open", nullptr), high(bars, "high", nullptr), low(bars, "low", nullptr), close(bars, "close", nullptr);
+        Values bidprice(bars, "bid_price", nullptr), bidsize(bars, "bid_size", nullptr), askprice(bars, "ask_price", nullptr), asksize(bars, "ask_size", nullptr);
+        Values first(bars, "first", nullptr), last(bars, "last", nullptr), volume(bars, "volume", nullptr), dollars(bars, "dollars", nullptr), trades(bars, "trades", nullptr);
+        Values vwap(bars, "vwap", nullptr), deviation(bars, "std", nullptr), mad(bars, "mad", nullptr), skewness(bars, "skewness", nullptr), kurtosis(bars, "kurtosis", nullptr);
+        Values buys(bars, "buys", nullptr), sells(bars, "sells", nullptr), buyvolume(bars, "buy_volume", nullptr), sellvolume(bars, "sell_volume", nullptr);
+
+        // all columns should be just as long
+        for (const Values *values : { &high, &low, &close, &bidprice, &bidsize, &askprice, &asksize, &first, &last, &volume, &dollars, &trades,
+                                      &vwap, &deviation, &mad, &skewness, &kurtosis, &buys, &sells, &buyvolume, &sellvolume })
+        {
+            // the bars are read up to the length of the open column
+            if (values->size() != open.size()) throw std::runtime_error("Invalid bars, expected columns of equal length");
+        }
+
+        // the coarser bars go in columns
+        auto columns = std::make_shared<BarColumns>();
+
+        // merging does not need the GIL
+        {
+            Unlocked unlocked;
+            Resample resample(columns.get(), size, mode);
+
+            // merge all the bars
+            for (size_t i = 0; i < open.size(); i++)
+            {
+                // the bar, from its statistics
+                resample.onBar(Accumulator(open.get<float>(i), high.get<float>(i), low.get<float>(i), close.get<float>(i),
+                    Quote(last.get<size_t>(i), bidprice.get<float>(i), bidsize.get<size_t>(i)), Quote(last.get<size_t>(i), askprice.get<float>(i), asksize.get<size_t>(i)),
+                    first.get<size_t>(i), last.get<size_t>(i), volume.get<size_t>(i), dollars.get<double>(i), trades.get<size_t>(i),
+                    vwap.get<float>(i), deviation.get<float>(i), mad.get<float>(i), skewness.get<float>(i), kurtosis.get<float>(i),
+                    buys.get<size_t>(i), sells.get<size_t>(i), buyvolume.get<size_t>(i), sellvolume.get<size_t>(i)));
+            }
+
+            // and the last one
+            resample.flush();
+        }
+
+        // wrap the columns
+        return column_dict(columns);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* multitime(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // input and the resolutions are required
+    const char *input = nullptr;
+    PyObject *list = nullptr;
+
+    // the time range, everything by default
+    unsigned long long start = 0;
+    unsigned long long end = SIZE_MAX;
+
+    // the keywords, only the time range is applicable
+    static const char* keywords[] = {"", "", "start", "end", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|$KK", const_cast<char**>(keywords), &input, &list, &start, &end)) throw std::runtime_error("Invalid arguments, expected input, seconds:list, start:int and end:int");
+
+        // the resolutions must be a sequence
+        PyObject *sequence = PySequence_Fast(list, "expected a list of seconds");
+        if (sequence == nullptr) throw std::runtime_error("Invalid arguments, expected a list of seconds");
+
+        // take all the resolutions
+        std::vector<size_t> seconds;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) seconds.push_back(PyLong_AsUnsignedLongLong(PySequence_Fast_GET_ITEM(sequence, i)));
+
+        // done with the sequence
+        Py_DECREF(sequence);
+
+        // they must all be numbers
+        if (PyErr_Occurred()) throw std::runtime_error("Invalid arguments, expected seconds to hold positive integers");
+
+        // the columns per resolution
+        std::vector<std::shared_ptr<BarColumns>> columns;
+        std::vector<Accumulator::Handler*> handlers;
+        for (size_t i = 0; i < seconds.size(); i++)
+        {
+            columns.push_back(std::make_shared<BarColumns>());
+            handlers.push_back(columns.back().get());
+        }
+
+        // the conversion does not need the GIL
+        {
+            Unlocked unlocked;
+            Convert::run(seconds, handlers, input, start, end);
+        }
+
+        // the result, a dict with an entry per resolution
+        PyObject *result = PyDict_New();
+        if (result == nullptr) return nullptr;
+
+        // fill the dict with the columns
+        for (size_t i = 0; i < seconds.size(); i++)
+        {
+            // create the key and the entry
+            PyObject *key = PyLong_FromSize_t(seconds[i]);
+            PyObject *entry = column_dict(columns[i]);
+
+            // the dict does not steal the references
+            if (key == nullptr || entry == nullptr || PyDict_SetItem(result, key, entry) < 0) { Py_XDECREF(key); Py_XDECREF(entry); Py_DECREF(result); return nullptr; }
+            Py_DECREF(key);
+            Py_DECREF(entry);
+        }
+
+        // done
+        return result;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* publish(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // input, the spec and the name of the ring are required
+    const char *input = nullptr;
+    PyObject *spec = nullptr;
+    const char *name = nullptr;
+    const char *symbol = "";
+    unsigned long long capacity = 4096;
+
+    // the time range, everything by default
+    unsigned long long start = 0;
+    unsigned long long end = SIZE_MAX;
+
+    // the keywords, the symbol, the capacity and the time range are applicable
+    static const char* keywords[] = {"", "", "", "symbol", "capacity", "start", "end", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sOs|$sKKK", const_cast<char**>(keywords), &input, &spec, &name, &symbol, &capacity, &start, &end)) throw std::runtime_error("Invalid arguments, expected input, spec, name, symbol:str, capacity:int, start:int and end:int");
+
+        // the processor, and the ring
+        auto processor = barspec(spec).create();
+        RingPublisher publisher(name, symbol, capacity);
+
+        // the conversion does not need the GIL
+        {
+            Unlocked unlocked;
+            Convert::run(*processor, publisher, input, start, end);
+        }
+
+        // the number of bars published
+        return PyLong_FromSize_t(publisher.published());
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* multi(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // input and the specs are required, the outputs are optional
+    const char *input = nullptr;
+    PyObject *list = nullptr;
+    PyObject *files = Py_None;
+
+    // the keywords, only outputs is applicable
+    static const char* keywords[] = {"", "", "outputs", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|$O", const_cast<char**>(keywords), &input, &list, &files)) throw std::runtime_error("Invalid arguments, expected input, specs and outputs:list");
+
+        // the specs and the output files
+        std::vector<BarSpec> specs;
+        std::vector<std::string> outputs;
+
+        // the specs must be a sequence
+        PyObject *sequence = PySequence_Fast(list, "expected a list of specs");
+        if (sequence == nullptr) throw std::runtime_error("Invalid arguments, expected a list of specs");
+
+        // parse the specs (not using a guard, so release the sequence on all paths)
+        try
+        {
+            // parse all specs
+            for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) specs.push_back(barspec(PySequence_Fast_GET_ITEM(sequence, i)));
+        }
+        catch (...)
+        {
+            // release the sequence
+            Py_DECREF(sequence);
+            throw;
+        }
+
+        // done with the sequence
+        Py_DECREF(sequence);
+
+        // parse the output files, if there are any
+        if (files != Py_None)
+        {
+            // the outputs must be a sequence
+            sequence = PySequence_Fast(files, "expected a list of outputs");
+            if (sequence == nullptr) throw std::runtime_error("Invalid arguments, expected outputs:list");
+
+            // take all the names
+            for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++)
+            {
+                // the name of the file
+                const char *name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(sequence, i));
+                if (name != nullptr) outputs.push_back(name);
+            }
+
+            // done with the sequence
+            Py_DECREF(sequence);
+
+            // must be a string per spec
+            if (outputs.size() != specs.size()) throw std::runtime_error("Invalid arguments, expected an output:str per spec");
+        }
+
+        // the printers with their output files, or the columns
+        std::vector<std::unique_ptr<std::ofstream>> streams;
+        std::vector<std::unique_ptr<BarPrinter>> printers;
+        std::vector<std::shared_ptr<BarColumns>> columns;
+        std::vector<Bar::Handler*> handlers;
+
+        // the conversion does not need the GIL
+        {
+            Unlocked unlocked;
+
+            // create the handlers
+            for (size_t i = 0; i < specs.size(); i++)
+            {
+                // without an output file, the bars go in columns
+                if (outputs.empty())
+                {
+                    columns.push_back(std::make_shared<BarColumns>());
+                    handlers.push_back(columns.back().get());
+                    continue;
+                }
+
+                // open the output file
+                streams.emplace_back(new std::ofstream(outputs[i], std::ios::trunc));
+                if (!streams.back()->good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+
+                // and print into it
+                printers.emplace_back(new BarPrinter(*streams.back()));
+                handlers.push_back(printers.back().get());
+            }
+
+            // convert into all the handlers
+            Convert::run(specs, handlers, input);
+        }
+
+        // the result, a list with an entry per spec
+        PyObject *result = PyList_New(specs.size());
+        if (result == nullptr) return nullptr;
+
+        // fill the list with the number of bars, or the columns
+        for (size_t i = 0; i < specs.size(); i++)
+        {
+            // create the entry
+            PyObject *entry = outputs.empty() ? column_dict(columns[i]) : PyLong_FromUnsignedLong(printers[i]->number());
+            if (entry == nullptr) { Py_DECREF(result); return nullptr; }
+
+            // list holds the reference
+            PyList_SET_ITEM(result, i, entry);
+        }
+
+        // done
+        return result;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  The bars of a single symbol in a demultiplexed file
+ */
+struct SymbolBars
+{
+    /**
+     *  The processor, the columns and the maker
+     */
+    std::unique_ptr<Processor> processor;
+    std::shared_ptr<BarColumns> columns = std::make_shared<BarColumns>();
+    BarMaker maker;
+
+    /**
+     *  The consolidated quotes, for if the maker should get the nbbo
+     */
+    Nbbo nbbo;
+
+    /**
+     *  Constructor
+     *  @param  spec
+     */
+    SymbolBars(const BarSpec &spec) : processor(spec.create()), maker(columns.get(), processor.get()), nbbo(&maker) {}
+};
+
+static PyObject* demux(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // input and the spec are required
+    const char *input = nullptr;
+    PyObject *spec = nullptr;
+    int threads = 0;
+    int nbbo = 0;
+    PyObject *filter = Py_None;
+    const char *warm = nullptr;
+
+    // the keywords, threads, nbbo, the filter and the warm store are applicable
+    static const char* keywords[] = {"", "", "threads", "nbbo", "filter", "warm", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|$ipOz", const_cast<char**>(keywords), &input, &spec, &threads, &nbbo, &filter, &warm)) throw std::runtime_error("Invalid arguments, expected input, spec, threads:int, nbbo:bool, filter:dict and warm:str");
+
+        // parse the spec
+        BarSpec parsed = barspec(spec);
+
+        // the bars of every symbol
+        std::vector<std::unique_ptr<SymbolBars>> symbols;
+
+        // the state of the day before, if there is a store
+        std::unique_ptr<WarmStore> store(warm ? new WarmStore(warm) : nullptr);
+
+        // the demultiplexer creates the bars for every new symbol
+        Demux demux([&symbols, &parsed, &store, nbbo](const std::string &symbol) -> EventProcessor* {
+            symbols.emplace_back(new SymbolBars(parsed));
+            if (store) store->warm(symbol, parsed, *symbols.back()->processor);
+            return nbbo ? static_cast<EventProcessor*>(&symbols.back()->nbbo) : &symbols.back()->maker;
+        }, std::max(threads, 0), filterspec(filter));
+
+        // the conversion does not need the GIL
+        {
+            Unlocked unlocked;
+
+            // open the file
+            std::ifstream in(input);
+            if (!in.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+            // process all symbols
+            demux.process(in);
+
+            // and complete the last bars
+            for (auto &symbol : symbols) symbol->maker.flush();
+
+            // store the state at the end of the day, for the next one
+            if (store)
+            {
+                for (size_t i = 0; i < symbols.size(); i++) store->put(demux.symbol(i), parsed, *symbols[i]->processor);
+                store->save();
+            }
+        }
+
+        // the result, the columns by symbol
+        PyObject *result = PyDict_New();
+        if (result == nullptr) return nullptr;
+
+        // fill the dictionary
+        for (size_t i = 0; i < symbols.size(); i++)
+        {
+            // create the entry
+            PyObject *entry = column_dict(symbols[i]->columns);
+            if (entry == nullptr || PyDict_SetItemString(result, demux.symbol(i).c_str(), entry) < 0) { Py_XDECREF(entry); Py_DECREF(result); return nullptr; }
+
+            // dictionary holds the reference
+            Py_DECREF(entry);
+        }
+
+        // done
+        return result;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Turn the statistics of the tasks of a driver into a list of dictionaries
+ *  @param  driver
+ *  @return PyObject*
+ */
+static PyObject *tasklist(const Driver &driver)
+{
+    // the result, a dictionary per task
+    PyObject *result = PyList_New(driver.tasks().size());
+    if (result == nullptr) return nullptr;
+
+    // fill the list
+    for (size_t i = 0; i < driver.tasks().size(); i++)
+    {
+        // the task
+        const auto &task = driver.tasks()[i];
+
+        // create the entry
+        PyObject *entry = Py_BuildValue("{s:s,s:s,s:k,s:k,s:d,s:k,s:s}", "input", task.input.c_str(), "output", task.output.c_str(), "bytes", task.bytes, "bars", task.bars, "seconds", task.seconds, "worker", task.worker, "error", task.error.c_str());
+        if (entry == nullptr) { Py_DECREF(result); return nullptr; }
+
+        // list holds the reference
+        PyList_SET_ITEM(result, i, entry);
+    }
+
+    // done
+    return result;
+}
+
+static PyObject* batch(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the list of jobs is required
+    PyObject *list = nullptr;
+    int threads = 0;
+
+    // the keywords, only threads is applicable
+    static const char* keywords[] = {"", "threads", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$i", const_cast<char**>(keywords), &list, &threads)) throw std::runtime_error("Invalid arguments, expected jobs and threads:int");
+
+        // the jobs must be a sequence
+        PyObject *sequence = PySequence_Fast(list, "expected a list of (input, output, spec) jobs");
+        if (sequence == nullptr) throw std::runtime_error("Invalid arguments, expected a list of (input, output, spec) jobs");
+
+        // the driver for all the jobs, filled while we still hold the GIL
+        Driver driver;
+
+        // parse the jobs (not using a guard, so release the sequence on all paths)
+        try
+        {
+            // iterate over the jobs
+            for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++)
+            {
+                // the input and output file and the specification
+                const char *input, *output;
+                PyObject *spec;
+
+                // parse the job
+                if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(sequence, i), "ssO", &input, &output, &spec)) throw std::runtime_error("Invalid job, expected (input:str, output:str, spec)");
+
+                // add the job
+                driver.add(input, output, barspec(spec));
+            }
+        }
+        catch (...)
+        {
+            // release the sequence
+            Py_DECREF(sequence);
+            throw;
+        }
+
+        // done with the sequence
+        Py_DECREF(sequence);
+
+        // the conversions do not need the GIL
+        {
+            Unlocked unlocked;
+            driver.run(std::max(threads, 0));
+        }
+
+        // report the first error
+        for (const auto &task : driver.tasks()) if (!task.error.empty()) throw std::runtime_error(task.error);
+
+        // the result, number of bars per job
+        PyObject *result = PyList_New(driver.tasks().size());
+        if (result == nullptr) return nullptr;
+
+        // fill the list
+        for (size_t i = 0; i < driver.tasks().size(); i++) PyList_SET_ITEM(result, i, PyLong_FromUnsignedLong(driver.tasks()[i].bars));
+
+        // done
+        return result;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* manifest(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the manifest is required
+    const char *input = nullptr;
+    int threads = 0;
+
+    // the keywords, only threads is applicable
+    static const char* keywords[] = {"", "threads", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|$i", const_cast<char**>(keywords), &input, &threads)) throw std::runtime_error("Invalid arguments, expected manifest and threads:int");
+
+        // the driver for all the tasks
+        Driver driver;
+
+        // the conversions do not need the GIL
+        {
+            Unlocked unlocked;
+
+            // open the manifest
+            std::ifstream in(input);
+            if (!in.good()) throw std::runtime_error("failed to open manifest: " + std::string(strerror(errno)));
+
+            // load and run it
+            driver.load(in);
+            driver.run(std::max(threads, 0));
+        }
+
+        // the statistics of every task, failed tasks have an error
+        return tasklist(driver);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* arrays(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the spec and the events are required, the events are either a structured array or four arrays
+    PyObject *spec = nullptr;
+    PyObject *type = nullptr;
+    PyObject *time = nullptr;
+    PyObject *price = nullptr;
+    PyObject *size = nullptr;
+
+    // the keywords, none are applicable
+    static const char* keywords[] = {"", "", "", "", "", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|OOO", const_cast<char**>(keywords), &spec, &type, &time, &price, &size)) throw std::runtime_error("Invalid arguments, expected spec and events");
+
+        // either all four arrays are given, or just the structured array
+        if (time != nullptr && (price == nullptr || size == nullptr)) throw std::runtime_error("Invalid arguments, expected type, time, price and size arrays");
+
+        // access the events
+        std::unique_ptr<Events> events(time == nullptr ? new Events(type) : new Events(type, time, price, size));
+
+        // make the bar processor
+        auto processor = barspec(spec).create();
+
+        // the columns are shared with the arrays we hand out
+        auto columns = std::make_shared<BarColumns>();
+
+        // processing does not need the GIL
+        {
+            Unlocked unlocked;
+
+            // create the barmaker
+            BarMaker barmaker(columns.get(), processor.get());
+
+            // feed the events
+            events->process(barmaker);
+
+            // flush the barmaker
+            barmaker.flush();
+        }
+
+        // wrap the columns
+        return column_dict(columns);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+/**
+ *  Parse a single file name or a list of file names
+ *  @param  object
+ *  @param  names
+ *  @return bool        whether it was a list
+ */
+static bool filenames(PyObject *object, std::vector<std::string> &names)
+{
+    // a single name
+    if (PyUnicode_Check(object)) { names.push_back(PyUnicode_AsUTF8(object)); return false; }
+
+    // otherwise it must be a sequence
+    PyObject *sequence = PySequence_Fast(object, "expected a list of file names");
+    if (sequence == nullptr) throw std::runtime_error("Invalid arguments, expected a file name or a list of file names");
+
+    // take all the names
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++)
+    {
+        // the name of the file
+        const char *name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(sequence, i));
+        if (name != nullptr) names.push_back(name);
+    }
+
+    // the number of names that we got
+    bool complete = static_cast<Py_ssize_t>(names.size()) == PySequence_Fast_GET_SIZE(sequence);
+
+    // done with the sequence
+    Py_DECREF(sequence);
+
+    // all of them must be strings
+    if (!complete) throw std::runtime_error("Invalid arguments, expected a list of file names");
+
+    // it was a list
+    return true;
 }
 
 static PyObject* performance(PyObject *self, PyObject *args, PyObject* kwargs) {
-    // input and output are both required
+    // input, actions and output are all required, actions and outputs may be lists
     const char *file;
-    const char *actions;
-    const char *output;
+    PyObject *actions;
+    PyObject *output;
 
-    // the keywords, only size is applicable
-    static const char* keywords[] = {"", "", NULL};
+    // the costs of trading
+    double fee = 0.0;
+    double minimum = 0.0;
+    double slippage = 0.0;
 
-    // amount of shares bought
-    size_t stocks = 0;
-    float money = 0.0;
+    // whether the quotes of all exchanges are consolidated first, and the filter for the records
+    int nbbo = 0;
+    PyObject *spec = Py_None;
+
+    // the keywords, the costs, nbbo and the filter are applicable
+    static const char* keywords[] = {"", "", "", "fee", "minimum", "slippage", "nbbo", "filter", NULL};
 
     // we may fail to parse the keywords, or something else might go wrong
     try
     {
         // allow the arguments
-        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sss", const_cast<char**>(keywords), &file, &actions)) throw std::runtime_error("Invalid arguments");
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sOO|$dddpO", const_cast<char**>(keywords), &file, &actions, &output, &fee, &minimum, &slippage, &nbbo, &spec)) throw std::runtime_error("Invalid arguments, expected fee:float, minimum:float, slippage:float, nbbo:bool and filter:dict");
+
+        // parse the filter
+        Filter filter = filterspec(spec);
+
+        // the action and output files
+        std::vector<std::string> inputs, outputs;
+        bool multiple = filenames(actions, inputs);
+        filenames(output, outputs);
+
+        // there must be an output per action file
+        if (inputs.size() != outputs.size()) throw std::runtime_error("Invalid arguments, expected an output file per action file");
+
+        /**
+         *  The result of a single strategy
+         */
+        struct Result
+        {
+            long position;
+            double cash, fees, value;
+            size_t traded, actions;
+        };
+
+        // the results of the strategies
+        std::vector<Result> results;
+
+        // the simulation does not need the GIL
+        {
+            Unlocked unlocked;
+
+            // open the files
+            std::ifstream s(file);
+            if (!s.good()) throw std::runtime_error("failed to open tape file: " + std::string(strerror(errno)));
+
+            // all the strategies are simulated in a single pass over the market data
+            MultiSimulated simulated;
+
+            // the files of the strategies
+            std::vector<std::unique_ptr<std::ifstream>> a;
+            std::vector<std::unique_ptr<std::ofstream>> o;
+
+            // add all strategies
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                // the actions file
+                a.emplace_back(new std::ifstream(inputs[i]));
+                if (!a.back()->good()) throw std::runtime_error("failed to open action file: " + std::string(strerror(errno)));
+
+                // output file, where a record is written for every action
+                o.emplace_back(new std::ofstream(outputs[i], std::ios::trunc));
+                if (!o.back()->good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+
+                // add the strategy, it has actions and an output
+                simulated.add(*a.back(), *o.back(), Costs(fee, minimum, slippage));
+            }
+
+            // the quotes of all exchanges may be consolidated first
+            Nbbo consolidated(&simulated);
+
+            // process the simulated data, and the actions after it
+            if (nbbo) Util::process(consolidated, s, 0, SIZE_MAX, &filter);
+            else Util::process(simulated, s, 0, SIZE_MAX, &filter);
+            simulated.flush();
+
+            // take the results
+            for (size_t i = 0; i < simulated.size(); i++)
+            {
+                // the strategy
+                const Strategy &strategy = simulated.strategy(i);
+
+                // store the result
+                results.push_back(Result{ strategy.position(), strategy.cash(), strategy.fees(), simulated.value(i), strategy.traded(), strategy.actions() });
+            }
+        }
+
+        // the results as dictionaries
+        PyObject *result = PyList_New(results.size());
+        if (result == nullptr) return nullptr;
+
+        // fill the list
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            // the result of the strategy
+            const Result &r = results[i];
+
+            // create the dictionary
+            PyObject *entry = Py_BuildValue("{s:l,s:d,s:d,s:d,s:n,s:n}", "position", r.position, "cash", r.cash, "fees", r.fees, "value", r.value, "traded", (Py_ssize_t)r.traded, "actions", (Py_ssize_t)r.actions);
+            if (entry == nullptr) { Py_DECREF(result); return nullptr; }
+
+            // list holds the reference
+            PyList_SET_ITEM(result, i, entry);
+        }
+
+        // a list for a list of strategies
+        if (multiple) return result;
+
+        // otherwise just the single result
+        PyObject *single = PyList_GetItem(result, 0);
+        Py_XINCREF(single);
+        Py_DECREF(result);
+        return single;
+    }
 
-        // open the files 
-        std::ifstream s(file);
-        if (!s.good()) throw std::runtime_error("failed to open tape file: " + std::string(strerror(errno)));
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
 
-        // the actions file
-        std::ifstream a(actions);
-        if (!a.good()) throw std::runtime_error("failed to open action file: " + std::string(strerror(errno)));
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
 
-        // output file, where at every trading junction the current state is appended
-        std::ofstream o(output, std::ios::app);
-        if (!o.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
-        
-        // the simulated data, has actions and an output
-        Simulated simulated(a, o);
+        // failed
+        return nullptr;
+    }
+}
 
-        // process the simulated data
-        Util::process(simulated, s);
+static PyObject* merge(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the inputs are required, the output and the spec are optional
+    PyObject *files = nullptr;
+    const char *output = nullptr;
+    PyObject *spec = Py_None;
+    PyObject *filter = Py_None;
+    int mml = 0;
+
+    // the keywords, the spec, the format and the filter are applicable
+    static const char* keywords[] = {"", "", "spec", "mml", "filter", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|z$OpO", const_cast<char**>(keywords), &files, &output, &spec, &mml, &filter)) throw std::runtime_error("Invalid arguments, expected inputs:list, output:str, spec, mml:bool and filter:dict");
+
+        // the input files
+        std::vector<std::string> inputs;
+        filenames(files, inputs);
+
+        // without a spec, the merged tape is written
+        if (spec == Py_None && output == nullptr) throw std::runtime_error("Invalid arguments, expected an output file or a spec");
+
+        // the merger of all inputs
+        Merge merger(mml ? TapeIndex::Mml : TapeIndex::Tape, filterspec(filter));
+        for (const auto &input : inputs) merger.add(input);
+
+        // without a spec we simply write the events
+        if (spec == Py_None)
+        {
+            // the merge does not need the GIL
+            Unlocked unlocked;
+
+            // open the output file
+            std::ofstream out(output, std::ios::trunc);
+            if (!out.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+
+            // write the merged tape
+            TapeWriter writer(out);
+            merger.process(writer);
+        }
+
+        // return the number of events
+        if (spec == Py_None) return PyLong_FromUnsignedLong(merger.events());
+
+        // otherwise we make bars
+        auto processor = barspec(spec).create();
+
+        // the bars either go to a file, or into columns
+        std::ofstream out;
+        std::unique_ptr<BarPrinter> printer;
+        auto columns = std::make_shared<BarColumns>();
+
+        // the merge does not need the GIL
+        {
+            Unlocked unlocked;
+
+            // open the output file, if there is one
+            if (output != nullptr) out.open(output, std::ios::trunc);
+            if (output != nullptr && !out.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+            if (output != nullptr) printer.reset(new BarPrinter(out));
+
+            // the bars of the merged events
+            BarMaker maker(printer ? static_cast<Bar::Handler*>(printer.get()) : columns.get(), processor.get());
+            merger.process(maker);
+            maker.flush();
+        }
+
+        // the number of bars, or the columns
+        return printer ? PyLong_FromUnsignedLong(printer->number()) : column_dict(columns);
     }
 
     // catch the runtime error we might have thrown
@@ -168,9 +1060,63 @@ static PyObject* performance(PyObject *self, PyObject *args, PyObject* kwargs) {
         // failed
         return nullptr;
     }
+}
 
-    //printf("Hello, %s!\n", name);
-    return PyLong_FromUnsignedLong(1);
+static PyObject* tapeindex(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // input is required
+    const char *input = nullptr;
+    int mml = 0;
+    unsigned long long interval = 1000;
+    PyObject *spec = Py_None;
+
+    // the keywords, the format, interval and the filter are applicable
+    static const char* keywords[] = {"", "mml", "interval", "filter", NULL};
+
+    // the number of entries in the index
+    size_t entries = 0;
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|$pKO", const_cast<char**>(keywords), &input, &mml, &interval, &spec)) throw std::runtime_error("Invalid arguments, expected mml:bool, interval:int and filter:dict");
+
+        // parse the filter, for the mml records
+        Filter filter = filterspec(spec);
+
+        // interval must be positive
+        if (interval == 0) throw std::runtime_error("Invalid arguments, expected interval > 0");
+
+        // building the index does not need the GIL
+        Unlocked unlocked;
+
+        // build the index of the file
+        TapeIndex index(input, mml ? TapeIndex::Mml : TapeIndex::Tape, interval, filter);
+
+        // and write it next to the input
+        std::ofstream o(std::string(input) + ".idx", std::ios::trunc | std::ios::binary);
+        if (!o.good()) throw std::runtime_error("failed to open index file: " + std::string(strerror(errno)));
+        index.save(o);
+
+        // number of entries
+        entries = index.size();
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+
+    // return the number of entries
+    return PyLong_FromUnsignedLong(entries);
 }
 
 static PyObject* mml_to_tape(PyObject *self, PyObject *args, PyObject *kwargs) {
@@ -178,16 +1124,26 @@ static PyObject* mml_to_tape(PyObject *self, PyObject *args, PyObject *kwargs) {
     const char *input = nullptr;
     const char *output = nullptr;
     size_t offset = 0;
+    int nbbo = 0;
+    PyObject *spec = Py_None;
 
-    // the keywords, only size is applicable
-    // the keywords, only size is applicable
-    static const char* keywords[] = {"", "", "", NULL};
+    // the keywords, nbbo and the filter are applicable
+    static const char* keywords[] = {"", "", "", "nbbo", "filter", NULL};
+
+    // the filter for the records
+    Filter filter;
 
     // we may fail to parse the keywords, or something else might go wrong
     try
     {
         // allow the arguments
-        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ssL", const_cast<char**>(keywords), &input, &output, &offset)) return nullptr;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ssL|$pO", const_cast<char**>(keywords), &input, &output, &offset, &nbbo, &spec)) return nullptr;
+
+        // parse the filter
+        filter = filterspec(spec);
+
+        // the conversion does not need the GIL
+        Unlocked unlocked;
 
         // open the files 
         std::ifstream i(input);
@@ -197,11 +1153,21 @@ static PyObject* mml_to_tape(PyObject *self, PyObject *args, PyObject *kwargs) {
         std::ofstream o(output, std::ofstream::trunc);
         if (!o.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
 
-        // tape maker
-        MmlTapeMaker maker(o, offset, Util::offset("09:30:00.000000"), Util::offset("15:55:00.000000"));
+        // the trading hours
+        size_t start = Util::offset("09:30:00.000000");
+        size_t end = Util::offset("15:55:00.000000");
 
-        // process the simulated data
-        Util::process(maker, i);
+        // tape maker, perhaps with the quotes of all exchanges consolidated first
+        MmlTapeMaker maker(o, offset, start, end);
+        Nbbo consolidated(&maker);
+
+        // with an index we do not have to parse the lines before the start, but
+        // the index only knows the last quote, not those of every exchange
+        if (!nbbo) TapeIndex::seek(i, input, start, maker, TapeIndex::Mml);
+
+        // process the simulated data, up to the end
+        if (nbbo) Util::process(consolidated, i, 0, end, &filter);
+        else Util::process(maker, i, 0, end, &filter);
     }
 
     // catch the runtime error we might have thrown
@@ -217,8 +1183,8 @@ static PyObject* mml_to_tape(PyObject *self, PyObject *args, PyObject *kwargs) {
         return nullptr;
     }
 
-    //printf("Hello, %s!\n", name);
-    return PyLong_FromUnsignedLong(1);
+    // the counters of the filter
+    return filterstats(filter);
 }
 
 static PyObject* negspreadtrades(PyObject *self, PyObject *args, PyObject *kwargs) {
@@ -236,6 +1202,9 @@ static PyObject* negspreadtrades(PyObject *self, PyObject *args, PyObject *kwarg
         // allow the arguments
         if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ss", const_cast<char**>(keywords), &input, &output)) return nullptr;
 
+        // the search does not need the GIL
+        Unlocked unlocked;
+
         // open the files 
         std::ifstream i(input);
         if (!i.good()) throw std::runtime_error("failed to open tape file: " + std::string(strerror(errno)));
@@ -268,6 +1237,105 @@ static PyObject* negspreadtrades(PyObject *self, PyObject *args, PyObject *kwarg
     return PyLong_FromUnsignedLong(1);
 }
 
+static PyObject* generate(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // the output is required
+    const char *output = nullptr;
+    int mml = 0;
+
+    // the parameters, with their defaults
+    Generator::Params params;
+    unsigned long long seed = params.seed, events = params.events, symbols = params.symbols, exchanges = params.exchanges, start = params.start, duration = params.duration;
+
+    // the keywords, all the parameters of the generator are applicable
+    static const char* keywords[] = {"", "events", "seed", "mml", "symbols", "exchanges", "start", "duration", "price", "volatility", "trades", "spread", "odd", "bursts", "length", "intensity", "conditions", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|$KKpKKKKddddddddd", const_cast<char**>(keywords), &output, &events, &seed, &mml, &symbols, &exchanges, &start, &duration,
+            &params.price, &params.volatility, &params.trades, &params.spread, &params.odd, &params.bursts, &params.length, &params.intensity, &params.conditions)) throw std::runtime_error("Invalid arguments, expected events:int, seed:int, mml:bool, symbols:int, exchanges:int, start:int, duration:int, and price, volatility, trades, spread, odd, bursts, length, intensity and conditions as float");
+
+        // the integer parameters
+        params.seed = seed;
+        params.events = events;
+        params.symbols = symbols;
+        params.exchanges = exchanges;
+        params.start = start;
+        params.duration = duration;
+
+        // a tape only has a single symbol
+        if (!mml && symbols != 1) throw std::runtime_error("a tape can only have a single symbol, use mml=True");
+
+        // the generation does not need the GIL
+        size_t count = 0;
+        {
+            Unlocked unlocked;
+            Generator generator(params);
+            count = generator.write(output, mml ? TapeIndex::Mml : TapeIndex::Tape);
+        }
+
+        // the number of events written
+        return PyLong_FromSize_t(count);
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return nullptr;
+    }
+}
+
+static PyObject* instrumentation(PyObject *self, PyObject *args, PyObject *kwargs) {
+    // whether to start over after reporting
+    int reset = 0;
+
+    // the keywords, only reset is applicable
+    static const char* keywords[] = {"reset", NULL};
+
+    // allow the arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$p", const_cast<char**>(keywords), &reset)) { PyErr_SetString(PyExc_TypeError, "Invalid arguments, expected reset:bool"); return nullptr; }
+
+    // what the threads that ended and this thread recorded
+    Instrumentation total = Instrumentation::total();
+    if (reset) Instrumentation::clear();
+
+    // the ticks are reported in nanoseconds
+    double scale = Instrumentation::enabled ? 1.0 / Instrumentation::ticksPerNanosecond() : 1.0;
+
+    // the histograms per stage
+    PyObject *stages = PyDict_New();
+    if (stages == nullptr) return nullptr;
+    for (size_t i = 0; i < Instrumentation::Stages; i++)
+    {
+        // the counts and the percentiles
+        const Histogram &histogram = total.stages[i];
+        PyObject *stage = Py_BuildValue("{s:K,s:d,s:d,s:d,s:d,s:d,s:d,s:d}",
+            "count", (unsigned long long)histogram.count(),
+            "mean", histogram.count() == 0 ? 0.0 : scale * histogram.total() / histogram.count(),
+            "min", scale * histogram.min(),
+            "p50", scale * histogram.percentile(0.5),
+            "p90", scale * histogram.percentile(0.9),
+            "p99", scale * histogram.percentile(0.99),
+            "p999", scale * histogram.percentile(0.999),
+            "max", scale * histogram.max());
+
+        // the dict does not steal the reference
+        if (stage == nullptr || PyDict_SetItemString(stages, Instrumentation::name(i), stage) < 0) { Py_XDECREF(stage); Py_DECREF(stages); return nullptr; }
+        Py_DECREF(stage);
+    }
+
+    // the counters, with the stages
+    return Py_BuildValue("{s:O,s:K,s:d,s:d,s:N}", "enabled", Instrumentation::enabled ? Py_True : Py_False, "events", (unsigned long long)total.events, "seconds", total.seconds, "rate", total.rate(), "stages", stages);
+}
+
 // Method definition object for this extension, these argumens mean:
 // ml_name: The name of the method
 // ml_meth: Function pointer to the method implementation
@@ -278,35 +1346,83 @@ static PyObject* negspreadtrades(PyObject *self, PyObject *args, PyObject *kwarg
 static PyMethodDef methods[] = { 
     {   
         "tick", (PyCFunction)sizedbar<TickBarProcessor>, METH_VARARGS | METH_KEYWORDS,
-        "Generate tick bars from a given file. size=trades:int"
+        "Generate tick bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=trades:int"
     },  
     {   
         "volume", (PyCFunction)sizedbar<VolumeBarProcessor>, METH_VARARGS | METH_KEYWORDS,
-        "Generate volume bars from a given file. size=volume:int"
+        "Generate volume bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=volume:int"
     },  
     {   
         "time", (PyCFunction)sizedbar<TimeBarProcessor>, METH_VARARGS | METH_KEYWORDS,
-        "Generate time bars from a given file. size=seconds:int"
+        "Generate time bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=seconds:int, gaps=emit the empty boxes, carrying the last close:bool"
     },  
     {   
         "change", (PyCFunction)sizedbar<ChangeBarProcessor>, METH_VARARGS | METH_KEYWORDS,
-        "Generate change bars from a given file. size=bips:int"
+        "Generate change bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=bips:int"
     },  
     {   
         "bachange", (PyCFunction)sizedbar<BAChangeBarProcessor>, METH_VARARGS | METH_KEYWORDS,
-        "Generate change bars from a given file. size=bips:int"
+        "Generate change bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=bips:int"
     }, 
     {   
         "dollar", (PyCFunction)dollarbar, METH_VARARGS | METH_KEYWORDS,
-        "Generate change bars from a given file. size=dollars:float"
+        "Generate change bars from a given file into an output file, or into numpy arrays if no output is given, optionally only from start to end. size=dollars:float"
     },  
+    {
+        "from_arrays", (PyCFunction)arrays, METH_VARARGS | METH_KEYWORDS,
+        "Generate bars from events in memory, given as type, time, price and size arrays or as a structured array with those fields. Returns numpy arrays, spec is (type, size) or a dict with the type and parameters."
+    },
+    {
+        "resample", (PyCFunction)resample, METH_VARARGS | METH_KEYWORDS,
+        "Resample bars (a dict of columns, as returned by the other functions) into coarser ones, by merging their statistics. by='count' merges every size bars, by='time' every box of size milliseconds. Returns a dict of numpy columns."
+    },
+    {
+        "multitime", (PyCFunction)multitime, METH_VARARGS | METH_KEYWORDS,
+        "Generate time bars of several resolutions (in seconds, increasing, multiples of the first) from a single pass, the coarser bars are merged from the finest (their mad is an upper bound of the mean absolute deviation, not the exact value). Returns a dict with the numpy columns per resolution, optionally only from start to end."
+    },
+    {
+        "publish", (PyCFunction)publish, METH_VARARGS | METH_KEYWORDS,
+        "Generate bars from a file into a ring in shared memory (like '/bars', replacing an existing one), for RingReader in other processes. Returns the number of bars published. symbol=in the records:str, capacity=records:int, optionally only from start to end."
+    },
+    {
+        "multi", (PyCFunction)multi, METH_VARARGS | METH_KEYWORDS,
+        "Generate bars for a list of specs (any bar type, including imbalance and runs bars) from a single parse of a file. Returns a list of numpy columns per spec, or the number of bars when outputs=files:list is given."
+    },
+    {
+        "manifest", (PyCFunction)manifest, METH_VARARGS | METH_KEYWORDS,
+        "Run all conversions of a manifest ('input,output,type,parameters...' per line) on a work-stealing pool, largest input first. Returns the statistics per task. threads=count:int"
+    },
+    {
+        "demux", (PyCFunction)demux, METH_VARARGS | METH_KEYWORDS,
+        "Generate bars for every symbol in an MML file with multiple symbols, returns a dictionary with numpy arrays by symbol. threads=workers:int, nbbo=consolidate the exchanges:bool, filter=conditions and exchanges:dict, warm=store to start the bars from the state of the day before, and to store the state at the end in:str"
+    },
+    {
+        "batch", (PyCFunction)batch, METH_VARARGS | METH_KEYWORDS,
+        "Generate bars for a list of (input, output, spec) jobs on a pool of threads, spec is (type, size) or a dict with the type and parameters. threads=count:int (default 0, all cores)"
+    },
     {
         "performance", (PyCFunction)performance, METH_VARARGS | METH_KEYWORDS,
-        "Evaluate performance of a strategy."
+        "Evaluate performance of a strategy, or of a list of strategies in a single pass over the tape, writes a record per action to the output(s). fee=per share:float, minimum=fee per fill:float, slippage=bips:float, nbbo=consolidate the exchanges:bool, filter=conditions and exchanges:dict"
+    },
+    {
+        "merge", (PyCFunction)merge, METH_VARARGS | METH_KEYWORDS,
+        "Merge a list of tape (or MML) files in time order, into a tape file, or into bars when a spec is given (written to the output, or returned as numpy arrays). spec=bar spec, mml=are mml:bool, filter=conditions and exchanges:dict"
+    },
+    {
+        "index", (PyCFunction)tapeindex, METH_VARARGS | METH_KEYWORDS,
+        "Build a time index next to a tape (or MML) file, used to seek to the start of a time range. mml=is mml:bool, interval=milliseconds:int, filter=conditions and exchanges:dict"
     },
     {
         "mml_to_tape", (PyCFunction)mml_to_tape, METH_VARARGS | METH_KEYWORDS,
-        "Convert MML file to tape file."
+        "Convert MML file to tape file, returns the number of records checked and dropped per reason. nbbo=consolidate the exchanges:bool, filter=conditions and exchanges:dict"
+    },
+    {
+        "generate", (PyCFunction)generate, METH_VARARGS | METH_KEYWORDS,
+        "Generate a synthetic tape (or MML file) with Poisson arrivals and bursts, a random walk of the price and random spreads and sizes, the same for the same seed. Returns the number of events. events=count:int, seed=int, mml=bool, symbols=count (mml only):int, exchanges=count:int, start=milliseconds:int, duration=milliseconds:int, price=first price:float, volatility=of the day:float, trades=fraction:float, spread=average ticks:float, odd=fraction of trades in odd lots:float, bursts=chance per event:float, length=average events in a burst:float, intensity=rate in a burst:float, conditions=fraction of trades the default filter drops:float"
+    },
+    {
+        "instrumentation", (PyCFunction)instrumentation, METH_VARARGS | METH_KEYWORDS,
+        "Latency histograms (in nanoseconds) of the stages parse, filter, fits, add and bar, and the events per second of the runs, of this thread and the threads that ended. Only recorded when built with STREAMBAR_INSTRUMENT=1 in the environment, enabled tells whether it was. reset=start over after reporting:bool"
     },
     {
         "negspreads", (PyCFunction)negspreadtrades, METH_VARARGS | METH_KEYWORDS,
@@ -332,5 +1448,26 @@ static struct PyModuleDef definition = {
 // the name keyword argument in setup.py's setup() call.
 PyMODINIT_FUNC PyInit__streambar(void) {
     Py_Initialize();
-    return PyModule_Create(&definition);
+
+    // the column type must be ready before arrays can be handed out
+    if (!column_ready() || !maker_ready() || !follower_ready() || !server_ready() || !reader_ready()) return nullptr;
+
+    // create the module
+    PyObject *module = PyModule_Create(&definition);
+    if (module == nullptr) return nullptr;
+
+    // add the types
+    Py_INCREF(&MakerType);
+    if (PyModule_AddObject(module, "BarMaker", reinterpret_cast<PyObject*>(&MakerType)) < 0) { Py_DECREF(&MakerType); Py_DECREF(module); return nullptr; }
+    Py_INCREF(&FollowerType);
+    if (PyModule_AddObject(module, "Follower", reinterpret_cast<PyObject*>(&FollowerType)) < 0) { Py_DECREF(&FollowerType); Py_DECREF(module); return nullptr; }
+    Py_INCREF(&ServerType);
+    if (PyModule_AddObject(module, "Server", reinterpret_cast<PyObject*>(&ServerType)) < 0) { Py_DECREF(&ServerType); Py_DECREF(module); return nullptr; }
+    Py_INCREF(&ReaderType);
+    if (PyModule_AddObject(module, "RingReader", reinterpret_cast<PyObject*>(&ReaderType)) == 0) return module;
+
+    // failed to add the type
+    Py_DECREF(&ReaderType);
+    Py_DECREF(module);
+    return nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+/**
+ *  Reader.h
+ *
+ *  Python object that reads the bars that another process publishes into a
+ *  ring in shared memory. Every read returns the records that arrived since
+ *  the previous one, as numpy arrays.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <memory>
+#include <vector>
+#include <string>
+#include <streambar.h>
+#include "column.h"
+
+/**
+ *  The records that were read, by column
+ */
+struct RecordColumns
+{
+    /**
+     *  The symbols, they are not numeric so they are returned as a list
+     */
+    std::vector<std::string> symbols;
+
+    /**
+     *  The numeric columns
+     */
+    std::vector<unsigned long> first, last, volume;
+    std::vector<float> open, high, low, close, vwap, std, bid, ask;
+    std::vector<double> dollars;
+    std::vector<uint32_t> trades, buys, sells;
+
+    /**
+     *  Add a record
+     *  @param  record
+     */
+    void add(const BarRecord &record)
+    {
+        // the symbol is not terminated if it is the full length
+        symbols.emplace_back(record.symbol, strnlen(record.symbol, sizeof(record.symbol)));
+
+        // the other fields
+        first.push_back(record.first);
+        last.push_back(record.last);
+        open.push_back(record.open);
+        high.push_back(record.high);
+        low.push_back(record.low);
+        close.push_back(record.close);
+        vwap.push_back(record.vwap);
+        std.push_back(record.std);
+        bid.push_back(record.bid);
+        ask.push_back(record.ask);
+        volume.push_back(record.volume);
+        dollars.push_back(record.dollars);
+        trades.push_back(record.trades);
+        buys.push_back(record.buys);
+        sells.push_back(record.sells);
+    }
+
+    /**
+     *  Visit all numeric columns
+     *  @param  visitor
+     */
+    template <typename Visitor>
+    void visit(Visitor &&visitor) const
+    {
+        visitor("first", first);
+        visitor("last", last);
+        visitor("open", open);
+        visitor("high", high);
+        visitor("low", low);
+        visitor("close", close);
+        visitor("vwap", vwap);
+        visitor("std", std);
+        visitor("bid", bid);
+        visitor("ask", ask);
+        visitor("volume", volume);
+        visitor("dollars", dollars);
+        visitor("trades", trades);
+        visitor("buys", buys);
+        visitor("sells", sells);
+    }
+};
+
+/**
+ *  The python object
+ */
+struct Reader
+{
+    PyObject_HEAD
+
+    /**
+     *  The C++ object
+     */
+    RingReader *reader;
+};
+
+/**
+ *  Construct the object, the name of the ring is required
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static int reader_init(Reader *self, PyObject *args, PyObject *kwargs)
+{
+    // the name is required
+    const char *name = nullptr;
+    int history = 1;
+
+    // the keywords, whether to read the records already in the ring is applicable
+    static const char* keywords[] = {"", "history", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|$p", const_cast<char**>(keywords), &name, &history)) throw std::runtime_error("Invalid arguments, expected name and history:bool");
+
+        // (re)create the C++ object
+        delete self->reader;
+        self->reader = nullptr;
+        self->reader = new RingReader(name, history);
+
+        // success
+        return 0;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return -1;
+    }
+}
+
+/**
+ *  Deallocate the object
+ *  @param  self
+ */
+static void reader_dealloc(Reader *self)
+{
+    // destruct the C++ object
+    delete self->reader;
+
+    // free the object
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+/**
+ *  Read the records that arrived
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static PyObject *reader_read(Reader *self, PyObject *args, PyObject *kwargs)
+{
+    // the maximum number of records, by default all
+    long long limit = -1;
+
+    // the keywords
+    static const char* keywords[] = {"limit", NULL};
+
+    // allow the arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|L", const_cast<char**>(keywords), &limit)) { PyErr_SetString(PyExc_TypeError, "Invalid arguments, expected limit:int"); return nullptr; }
+
+    // must be initialized
+    if (self->reader == nullptr) { PyErr_SetString(PyExc_TypeError, "RingReader is not initialized"); return nullptr; }
+
+    // read the records, it does not block so there is no need to release the GIL
+    auto columns = std::make_shared<RecordColumns>();
+    BarRecord record;
+    for (long long count = 0; count != limit && self->reader->read(record); count++) columns->add(record);
+
+    // the numeric columns
+    PyObject *result = column_dict(columns);
+    if (result == nullptr) return nullptr;
+
+    // and the symbols
+    PyObject *symbols = PyList_New(columns->symbols.size());
+    if (symbols == nullptr) { Py_DECREF(result); return nullptr; }
+    for (size_t i = 0; i < columns->symbols.size(); i++) PyList_SET_ITEM(symbols, i, PyUnicode_FromStringAndSize(columns->symbols[i].data(), columns->symbols[i].size()));
+    PyDict_SetItemString(result, "symbol", symbols);
+    Py_DECREF(symbols);
+
+    // return the columns
+    return result;
+}
+
+/**
+ *  The counters of the reader
+ *  @param  self
+ */
+static PyObject *reader_stats(Reader *self, PyObject *unused)
+{
+    // must be initialized
+    if (self->reader == nullptr) { PyErr_SetString(PyExc_TypeError, "RingReader is not initialized"); return nullptr; }
+
+    // the position, the lost records, and the waiting ones
+    return Py_BuildValue("{s:k,s:k,s:k}", "position", self->reader->position(), "lost", self->reader->lost(), "available", self->reader->available());
+}
+
+/**
+ *  Methods of the object
+ */
+static PyMethodDef reader_methods[] = {
+    {
+        "read", (PyCFunction)reader_read, METH_VARARGS | METH_KEYWORDS,
+        "Read the records that arrived since the previous read, at most limit=records:int. Returns them as numpy arrays, and the symbols as a list. Does not wait."
+    },
+    {
+        "stats", (PyCFunction)reader_stats, METH_NOARGS,
+        "Number of the next record, of the records that were overwritten before they were read, and of the records waiting."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+/**
+ *  The reader type
+ */
+static PyTypeObject ReaderType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "_streambar.RingReader",
+};
+
+/**
+ *  Initialize the reader type, called once when the module is loaded
+ *  @return bool
+ */
+static bool reader_ready()
+{
+    ReaderType.tp_basicsize = sizeof(Reader);
+    ReaderType.tp_dealloc = (destructor)reader_dealloc;
+    ReaderType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ReaderType.tp_doc = "Reads the bars that are published into a ring in shared memory, by publish() in another process. RingReader(name, history=True), history starts at the oldest record still in the ring instead of at the next one.";
+    ReaderType.tp_methods = reader_methods;
+    ReaderType.tp_init = (initproc)reader_init;
+    ReaderType.tp_new = PyType_GenericNew;
+    return PyType_Ready(&ReaderType) == 0;
+}
@@ -0,0 +1,228 @@
+/**
+ *  Server.h
+ *
+ *  Python object that runs an ingest server in a thread of its own. The
+ *  clients connect over a Unix domain socket (or TCP on the loopback
+ *  interface), send their events as binary messages, and receive the bars
+ *  of the symbols they subscribed to. The thread runs without the GIL, so
+ *  the clients may well be in the same process.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <streambar.h>
+#include "unlocked.h"
+#include "spec.h"
+
+/**
+ *  The C++ side of the object, the server and the thread that runs it
+ */
+struct Serving
+{
+    /**
+     *  The server
+     */
+    Ingest server;
+
+    /**
+     *  The error that stopped the thread, if any
+     */
+    std::mutex mutex;
+    std::string error;
+
+    /**
+     *  The thread
+     */
+    std::thread thread;
+
+    /**
+     *  Constructor, starts the thread
+     *  @param  spec
+     *  @param  address     the socket file, or the port
+     */
+    template <typename Address>
+    Serving(const BarSpec &spec, const Address &address) : server(spec, address), thread([this]() {
+
+        // run until stopped, an error is kept for the stats
+        try { server.run(); }
+        catch (const std::runtime_error &e) { std::lock_guard<std::mutex> lock(mutex); error = e.what(); }
+    }) {}
+
+    /**
+     *  Destructor, stops the thread
+     */
+    ~Serving()
+    {
+        // stop, and wait for it
+        server.stop();
+        thread.join();
+    }
+};
+
+/**
+ *  The python object
+ */
+struct Server
+{
+    PyObject_HEAD
+
+    /**
+     *  The C++ object
+     */
+    Serving *serving;
+};
+
+/**
+ *  Stop the thread and destruct the C++ object
+ *  @param  self
+ */
+static void server_close(Server *self)
+{
+    // the thread may have to finish what it is doing, which does not need the GIL
+    Serving *serving = self->serving;
+    self->serving = nullptr;
+    Unlocked unlocked;
+    delete serving;
+}
+
+/**
+ *  Construct the object, the address and the spec are required
+ *  @param  self
+ *  @param  args
+ *  @param  kwargs
+ */
+static int server_init(Server *self, PyObject *args, PyObject *kwargs)
+{
+    // the address and the spec are required
+    PyObject *address = nullptr;
+    PyObject *spec = nullptr;
+
+    // the keywords, nothing else is applicable
+    static const char* keywords[] = {"", "", NULL};
+
+    // we may fail to parse the keywords, or something else might go wrong
+    try
+    {
+        // allow the arguments
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO", const_cast<char**>(keywords), &address, &spec)) throw std::runtime_error("Invalid arguments, expected address and spec");
+
+        // the spec first, it may fail
+        BarSpec bar = barspec(spec);
+
+        // stop a server that was already running
+        server_close(self);
+
+        // a socket file, or a port
+        if (PyUnicode_Check(address)) self->serving = new Serving(bar, std::string(PyUnicode_AsUTF8(address)));
+        else if (PyLong_Check(address)) self->serving = new Serving(bar, static_cast<uint16_t>(PyLong_AsUnsignedLong(address)));
+        else throw std::runtime_error("Invalid address, expected a socket file:str or a port:int");
+
+        // success
+        return 0;
+    }
+
+    // catch the runtime error we might have thrown
+    catch (const std::runtime_error &e)
+    {
+        // clear previous error
+        PyErr_Clear();
+
+        // set the string
+        PyErr_SetString(PyExc_TypeError, e.what());
+
+        // failed
+        return -1;
+    }
+}
+
+/**
+ *  Deallocate the object
+ *  @param  self
+ */
+static void server_dealloc(Server *self)
+{
+    // stop the server
+    server_close(self);
+
+    // free the object
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+/**
+ *  Stop the server, the clients are disconnected
+ *  @param  self
+ */
+static PyObject *server_stop(Server *self, PyObject *unused)
+{
+    // stop it, if it is running
+    server_close(self);
+
+    // nothing to return
+    Py_RETURN_NONE;
+}
+
+/**
+ *  The counters of the server
+ *  @param  self
+ */
+static PyObject *server_stats(Server *self, PyObject *unused)
+{
+    // must be running
+    if (self->serving == nullptr) { PyErr_SetString(PyExc_TypeError, "Server is not running"); return nullptr; }
+
+    // the error, if the thread stopped
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(self->serving->mutex);
+        error = self->serving->error;
+    }
+
+    // the counters
+    const Ingest &server = self->serving->server;
+    return Py_BuildValue("{s:k,s:k,s:k,s:k,s:H,s:s}", "events", server.events(), "bars", server.bars(), "clients", server.clients(), "symbols", server.symbols(), "port", server.port(), "error", error.c_str());
+}
+
+/**
+ *  Methods of the object
+ */
+static PyMethodDef server_methods[] = {
+    {
+        "stop", (PyCFunction)server_stop, METH_NOARGS,
+        "Stop the server, the clients are disconnected and the open bars are dropped."
+    },
+    {
+        "stats", (PyCFunction)server_stats, METH_NOARGS,
+        "Number of events processed, bars published, clients connected and symbols seen, the port (0 on a socket file) and the error that stopped the server (empty if none)."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+/**
+ *  The server type
+ */
+static PyTypeObject ServerType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "_streambar.Server",
+};
+
+/**
+ *  Initialize the server type, called once when the module is loaded
+ *  @return bool
+ */
+static bool server_ready()
+{
+    ServerType.tp_basicsize = sizeof(Server);
+    ServerType.tp_dealloc = (destructor)server_dealloc;
+    ServerType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ServerType.tp_doc = "Ingest server in a thread of its own, that makes bars per symbol of the binary events that clients send, and publishes them to the subscribers. Server(address, spec), the address is a socket file:str or a port:int on the loopback interface (0 picks a free one), spec is (type, size) or a dict with the type and parameters. Events are messages of struct format '<BBHIQd8s' (type, exchange, reserved, size, time, price, symbol), type 5 subscribes to the symbol (empty for all) and type 6 completes its open bar. Bars are records of format '<8sQQffffffffQdIIII'.";
+    ServerType.tp_methods = server_methods;
+    ServerType.tp_init = (initproc)server_init;
+    ServerType.tp_new = PyType_GenericNew;
+    return PyType_Ready(&ServerType) == 0;
+}
@@ -2,8 +2,12 @@
 # encoding: utf-8
 
 from distutils.core import setup, Extension
+import os
 
-module = Extension('_streambar', sources = ['module.cpp'], extra_compile_args=['-I../'])
+# the instrumentation of the stages is only compiled in on request
+macros = [('STREAMBAR_INSTRUMENT', '1')] if os.environ.get('STREAMBAR_INSTRUMENT', '0') != '0' else []
+
+module = Extension('_streambar', sources = ['module.cpp'], extra_compile_args=['-I../'], define_macros=macros)
 
 setup(name='streambar',
       version='0.1.0',
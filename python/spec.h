@@ -0,0 +1,71 @@
+/**
+ *  Spec.h
+ *
+ *  Conversion of python bar specifications into a BarSpec.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <streambar.h>
+
+/**
+ *  Parse a bar specification, this is either a tuple (type, size) or a
+ *  dictionary with the type and the named parameters of the bar.
+ *  @param  object
+ *  @return BarSpec
+ */
+static BarSpec barspec(PyObject *object)
+{
+    // a tuple only holds the type and the size
+    if (PyTuple_Check(object))
+    {
+        // the type and size of the bar
+        const char *type;
+        double size;
+
+        // parse the tuple
+        if (!PyArg_ParseTuple(object, "sd", &type, &size)) throw std::runtime_error("Invalid bar specification, expected (type:str, size:float)");
+
+        // construct the spec
+        return BarSpec(type, size);
+    }
+
+    // otherwise it should be a dictionary
+    if (!PyDict_Check(object)) throw std::runtime_error("Invalid bar specification, expected tuple or dict");
+
+    // the type is required
+    PyObject *type = PyDict_GetItemString(object, "type");
+    if (type == nullptr || !PyUnicode_Check(type)) throw std::runtime_error("Invalid bar specification, expected type:str");
+
+    // the parameters
+    std::map<std::string, double> params;
+
+    // iterate over the dictionary
+    PyObject *key, *value;
+    Py_ssize_t position = 0;
+    while (PyDict_Next(object, &position, &key, &value))
+    {
+        // we already have the type
+        if (value == type) continue;
+
+        // keys must be strings
+        const char *name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+        if (name == nullptr) throw std::runtime_error("Invalid bar specification, expected parameter names to be str");
+
+        // and all parameters are numbers
+        double number = PyFloat_AsDouble(value);
+        if (number == -1.0 && PyErr_Occurred()) throw std::runtime_error("Invalid bar specification, expected " + std::string(name) + ":float");
+
+        // store the parameter
+        params[name] = number;
+    }
+
+    // construct the spec
+    return BarSpec(PyUnicode_AsUTF8(type), std::move(params));
+}
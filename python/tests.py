@@ -4,8 +4,13 @@ import tempfile
 import pandas as pd 
 import numpy as np
 from io import StringIO
-from numpy.testing import assert_array_equal
+from numpy.testing import assert_array_equal, assert_allclose
 import os
+import sys
+import socket
+import struct
+import time
+import threading
 
 class TestBars(unittest.TestCase):
     def setUp(self):
@@ -31,6 +36,22 @@ class TestBars(unittest.TestCase):
         assert_array_equal(df['vwap'].values, [101.25, 102.5, 102.5, 102.5, 102.5, 102.5])
         assert_array_equal(df['trades'].values, [2, 2, 2, 2, 2, 1])
 
+    def test_skewness(self):
+        # bars of three trades, two low and one high, and the other way around
+        tape = "event,time,price,size\n3,1000000,105,100\n2,1000000,100,100\n"
+        prices = [100, 100, 102.5, 102.5, 102.5, 100]
+        with open(self._fname, "w") as f: f.write(tape + "".join("1,%d,%s,100\n" % (1000000 + i, price) for i, price in enumerate(prices)))
+
+        # the printed skewness keeps its sign
+        self.assertEqual(streambar.tick(self._fname, self._fname + ".csv", size=3), 2)
+        printed = pd.read_csv(self._fname + ".csv")
+        os.unlink(self._fname + ".csv")
+        assert_allclose(printed['skewness'].values, [np.sqrt(0.5), -np.sqrt(0.5)], rtol=1e-4)
+
+        # symmetric bars have none
+        self.assertEqual(streambar.tick("tests/small.tape", self._fname, size=2), 6)
+        assert_array_equal(pd.read_csv(self._fname)['skewness'].values, np.zeros(6))
+
     def test_tick_incremental(self):
         # should be 6 bars in total, with the last one being off
         self.assertEqual(streambar.tick("tests/incremental.tape", self._fname, size=2), 6)
@@ -123,6 +144,550 @@ class TestBars(unittest.TestCase):
         # check the data
         assert_array_equal(df['volume'].values, [600, 400, 500, 600, 700, 800, 900, 1000, 1100])
 
+    def test_tick_columns(self):
+        # without an output file, we get the columns back
+        columns = streambar.tick("tests/small.tape", size=2)
+
+        # check the data
+        assert_array_equal(columns['volume'], [200, 200, 200, 200, 200, 100])
+        assert_array_equal(columns['buys'], [1, 2, 2, 2, 2, 1])
+        assert_array_equal(columns['vwap'], [101.25, 102.5, 102.5, 102.5, 102.5, 102.5])
+        assert_array_equal(columns['trades'], [2, 2, 2, 2, 2, 1])
+
+    def test_columns_match_file(self):
+        # write the bars to a file, and keep them in memory
+        self.assertEqual(streambar.dollar("tests/incremental.tape", self._fname, size=35000), 9)
+        columns = streambar.dollar("tests/incremental.tape", None, size=35000)
+
+        # open as a dataframe
+        df = pd.read_csv(self._fname)
+
+        # every column in the file is also in memory
+        self.assertEqual(list(df.columns), list(columns.keys()))
+        for name in df.columns: np.testing.assert_allclose(df[name].values, columns[name], rtol=1e-5)
+
+    def test_batch(self):
+        # second output file
+        other = self._fname + ".other"
+
+        # run two jobs on the pool, with both kinds of specifications
+        jobs = [("tests/small.tape", self._fname, ("tick", 2)), ("tests/incremental.tape", other, {"type": "dollar", "size": 35000})]
+        self.assertEqual(streambar.batch(jobs, threads=2), [6, 9])
+
+        # check the data
+        assert_array_equal(pd.read_csv(self._fname)['volume'].values, [200, 200, 200, 200, 200, 100])
+        assert_array_equal(pd.read_csv(other)['volume'].values, [600, 400, 500, 600, 700, 800, 900, 1000, 1100])
+        os.unlink(other)
+
+        # the threads default to all cores
+        self.assertEqual(streambar.batch(jobs[:1]), [6])
+
+        # errors are reported for the failing job
+        self.assertRaises(TypeError, streambar.batch, [("nx", self._fname, ("tick", 2))])
+        self.assertRaises(TypeError, streambar.batch, [("tests/small.tape", self._fname, ("nx", 2))])
+
+    def test_manifest(self):
+        # second output file, and the manifest
+        other = self._fname + ".other"
+        manifest = self._fname + ".manifest"
+
+        # a task per line, with a plain size or with named parameters
+        with open(manifest, "w") as f:
+            f.write("# comments are skipped\n")
+            f.write("tests/small.tape,%s,tick,2\n" % self._fname)
+            f.write("tests/incremental.tape,%s,dollar,size=35000\n" % other)
+            f.write("nx,/nx/output.csv,tick,2\n")
+
+        # run them on two threads
+        tasks = streambar.manifest(manifest, threads=2)
+        os.unlink(manifest)
+
+        # the statistics are in the order of the manifest
+        self.assertEqual([task['bars'] for task in tasks], [6, 9, 0])
+        self.assertEqual([task['error'] == "" for task in tasks], [True, True, False])
+        self.assertTrue(all(task['worker'] < 2 and task['seconds'] >= 0 for task in tasks))
+        self.assertGreater(tasks[1]['bytes'], tasks[0]['bytes'])
+
+        # the bars were written
+        assert_array_equal(pd.read_csv(self._fname)['volume'].values, [200, 200, 200, 200, 200, 100])
+        os.unlink(other)
+
+    def test_incremental_maker(self):
+        # load the events
+        events = pd.read_csv("tests/small.tape")
+
+        # maker that keeps the state between batches
+        maker = streambar.BarMaker(("tick", 2))
+
+        # feed the events in batches of three
+        volumes = []
+        for start in range(0, len(events), 3):
+            batch = events.iloc[start:start + 3]
+            volumes.append(maker.process(batch['event'].values, batch['time'].values, batch['price'].values, batch['size'].values)['volume'])
+
+        # and complete the last bar
+        volumes.append(maker.flush()['volume'])
+
+        # same bars as the whole file at once
+        assert_array_equal(np.concatenate(volumes), [200, 200, 200, 200, 200, 100])
+
+        # arrays must be equally long
+        self.assertRaises(TypeError, maker.process, np.ones(2), np.ones(2), np.ones(2), np.ones(3))
+
+    def test_reorder(self):
+        # swap some of the trades, they arrive a second out of order
+        events = pd.read_csv("tests/incremental.tape")
+        shuffled = events.iloc[[0, 1, 2, 4, 3, 5, 7, 6, 8, 9, 10, 11, 12]]
+
+        # with a window of two seconds, the bars are the same as in order
+        maker = streambar.BarMaker(("tick", 2), window=2000)
+        bars = maker.process(shuffled['event'].values, shuffled['time'].values, shuffled['price'].values, shuffled['size'].values)['volume']
+
+        # a trade that is far too late is dropped
+        late = maker.process(np.array([1]), np.array([1000500]), np.array([102.5]), np.array([100]))['volume']
+        self.assertEqual(maker.stats()['late'], 1)
+        self.assertGreater(maker.stats()['held'], 0)
+
+        # the held events are passed on when flushing
+        bars = np.concatenate([bars, late, maker.flush()['volume']])
+        assert_array_equal(bars, [300, 700, 1100, 1500, 1900, 1100])
+        self.assertEqual(maker.stats()['held'], 0)
+
+    def test_clock(self):
+        # the first two trades are in the first box of two seconds
+        events = pd.read_csv("tests/incremental.tape").iloc[:4]
+        maker = streambar.BarMaker(("time", 2), gaps=True)
+        self.assertEqual(len(maker.process(events['event'].values, events['time'].values, events['price'].values, events['size'].values)['volume']), 0)
+
+        # the clock closes the bar at the end of its box, without another trade
+        assert_array_equal(maker.clock(1002000)['volume'], [300])
+
+        # the empty boxes are gaps, that carry the close
+        gaps = maker.clock(1008000)
+        assert_array_equal(gaps['first'], [1002000, 1004000, 1006000])
+        assert_array_equal(gaps['close'], [102.5, 102.5, 102.5])
+        assert_array_equal(gaps['volume'], [0, 0, 0])
+
+        # nothing more until the next box is over
+        self.assertEqual(len(maker.clock(1009900)['volume']), 0)
+
+        # a stale quote from before the box does not split the bar
+        maker = streambar.BarMaker(("time", 1))
+        maker.process(events['event'].values[:2], events['time'].values[:2], events['price'].values[:2], events['size'].values[:2])
+        maker.process(np.array([1, 2, 1]), np.array([1000001, 999998, 1000002]), np.array([102.5, 100, 102.5]), np.array([100, 100, 100]))
+        assert_array_equal(maker.flush()['first'], [1000001])
+
+    def test_snapshot(self):
+        # the bars of all events at once
+        events = pd.read_csv("tests/incremental.tape")
+        spec = {"type": "tickimbalance", "E_T": 3, "P_b": 0.5}
+        fields = lambda part: (part['event'].values, part['time'].values, part['price'].values, part['size'].values)
+        maker = streambar.BarMaker(spec)
+        expected = np.concatenate([maker.process(*fields(events))['volume'], maker.flush()['volume']])
+
+        # half of the events, and then the rest in a restored maker
+        first = streambar.BarMaker(spec)
+        bars = first.process(*fields(events.iloc[:7]))['volume']
+        snapshot = first.save()
+        restored = streambar.BarMaker(spec)
+        restored.load(snapshot)
+        bars = np.concatenate([bars, restored.process(*fields(events.iloc[7:]))['volume'], restored.flush()['volume']])
+        assert_array_equal(bars, expected)
+
+        # it only loads into a maker of the same type
+        self.assertRaises(TypeError, streambar.BarMaker(("tick", 2)).load, snapshot)
+        self.assertRaises(TypeError, streambar.BarMaker(spec).load, snapshot[:10])
+
+        # a snapshot that fails to load leaves the maker as it was
+        for data, window in [(snapshot[:-3], 0), (snapshot, 2000)]:
+            maker = streambar.BarMaker(spec, window=window)
+            bars = maker.process(*fields(events.iloc[:7]))['volume']
+            self.assertRaises(TypeError, maker.load, data)
+            bars = np.concatenate([bars, maker.process(*fields(events.iloc[7:]))['volume'], maker.flush()['volume']])
+            assert_array_equal(bars, expected)
+
+    def test_follow(self):
+        # a tape that is still being written, with the header and part of a line
+        lines = open("tests/incremental.tape").read().splitlines(True)
+        with open(self._fname, "w") as f: f.write("".join(lines[:6]) + lines[6][:5])
+        follower = streambar.Follower(self._fname, ("tick", 2))
+
+        # only the complete lines are parsed, the partial one waits
+        assert_array_equal(follower.poll()['volume'], [300])
+        self.assertEqual(follower.stats()['pending'], 5)
+        self.assertEqual(follower.stats()['events'], 5)
+
+        # the rest is appended, the state of the bar was kept
+        with open(self._fname, "a") as f: f.write(lines[6][5:] + "".join(lines[7:]).strip() + "\n")
+        bars = follower.poll(timeout=1000)['volume']
+        bars = np.concatenate([bars, follower.flush()['volume']])
+        assert_array_equal(bars, streambar.tick("tests/incremental.tape", size=2)['volume'][1:])
+
+        # nothing new, so nothing to wait for
+        self.assertEqual(len(follower.poll(timeout=10)['volume']), 0)
+
+        # while a poll waits forever in another thread, the stats can still be read
+        follower = streambar.Follower(self._fname, ("tick", 2))
+        follower.poll()
+        waiting = threading.Thread(target=follower.poll, kwargs={"timeout": -1}, daemon=True)
+        waiting.start()
+        self.assertEqual(follower.stats()['events'], 13)
+
+        # and the poll returns once there is something new
+        with open(self._fname, "a") as f: f.write(lines[-1].strip() + "\n")
+        waiting.join(10)
+        self.assertFalse(waiting.is_alive())
+        self.assertEqual(follower.stats()['events'], 14)
+
+    def replay(self, client, events, count, symbol=b"TEST"):
+        # receive the bars in another thread, stamped when they arrive, and wait (generously) for the number we expect
+        client.settimeout(10)
+        bars, arrivals = [], []
+        def receive():
+            for i in range(count):
+                bars.append(client.recv(88, socket.MSG_WAITALL))
+                arrivals.append(time.perf_counter())
+        receiver = threading.Thread(target=receive)
+        receiver.start()
+
+        # send the events, stamped when they go out, and complete the open bar
+        sent = []
+        for event in events.itertuples(index=False):
+            sent.append(time.perf_counter())
+            client.sendall(struct.pack("<BBHIQd8s", event.event, 0, 0, event.size, event.time, event.price, symbol))
+        client.sendall(struct.pack("<BBHIQd8s", 6, 0, 0, 0, 0, 0.0, b""))
+        receiver.join()
+        bars = [struct.unpack("<8sQQffffffffQdIIII", bar) for bar in bars]
+
+        # the latency of the bars, from the first event at the time of their last one, but not of the flushed bar
+        completed = np.searchsorted(events['time'].values, [bar[2] for bar in bars[:-1]])
+        return bars, np.array(arrivals[:-1]) - np.array(sent)[completed]
+
+    def test_server(self):
+        # a regular file is not replaced by the socket
+        self.assertRaises(TypeError, streambar.Server, self._fname, ("tick", 2))
+        self.assertTrue(os.path.isfile(self._fname))
+
+        # a server on a socket file
+        os.unlink(self._fname)
+        server = streambar.Server(self._fname, ("tick", 2))
+        client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        client.connect(self._fname)
+
+        # subscribe to all symbols, and replay the tape over the same connection
+        client.sendall(struct.pack("<BBHIQd8s", 5, 0, 0, 0, 0, 0.0, b""))
+        expected = streambar.tick("tests/incremental.tape", size=2)
+        bars, latencies = self.replay(client, pd.read_csv("tests/incremental.tape"), len(expected['volume']))
+
+        # the same bars as from the file
+        self.assertEqual([bar[0] for bar in bars], [b"TEST\0\0\0\0"] * len(expected['volume']))
+        assert_array_equal([bar[11] for bar in bars], expected['volume'])
+        assert_array_equal([bar[3] for bar in bars], expected['open'])
+        assert_array_equal([bar[2] for bar in bars], expected['last'])
+        assert_array_equal([bar[13] for bar in bars], expected['trades'])
+
+        # the latency percentiles, they are reported but not bounded, as they depend on the load of the machine
+        self.assertEqual(len(latencies), len(expected['volume']) - 1)
+        p50, p99, p999 = np.percentile(latencies, [50, 99, 99.9])
+        self.assertTrue(np.all(np.isfinite([p50, p99, p999])) and p50 <= p99 <= p999)
+        print("\nserver latency p50 %.1f us, p99 %.1f us, p999 %.1f us" % (p50 * 1e6, p99 * 1e6, p999 * 1e6), file=sys.stderr)
+
+        # the counters, the commands are not events
+        client.close()
+        stats = server.stats()
+        self.assertEqual((stats['events'], stats['bars'], stats['symbols'], stats['port']), (13, 6, 1, 0))
+        server.stop()
+
+        # the socket file of a previous run is replaced
+        streambar.Server(self._fname, ("tick", 2)).stop()
+
+        # also on tcp, on a free port
+        server = streambar.Server(0, ("tick", 2))
+        client = socket.create_connection(("127.0.0.1", server.stats()['port']))
+        client.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        client.sendall(struct.pack("<BBHIQd8s", 5, 0, 0, 0, 0, 0.0, b"TEST"))
+        bars, latencies = self.replay(client, pd.read_csv("tests/incremental.tape"), len(expected['volume']))
+        assert_array_equal([bar[11] for bar in bars], expected['volume'])
+        client.close()
+        server.stop()
+
+        # invalid addresses are reported
+        self.assertRaises(TypeError, streambar.Server, 1.5, ("tick", 2))
+
+    def test_ring(self):
+        # publish the bars into a ring in shared memory, and read them back
+        ring = "/streambar-test-%d" % os.getpid()
+        self.assertEqual(streambar.publish("tests/incremental.tape", ("tick", 2), ring, symbol="TEST"), 6)
+        reader = streambar.RingReader(ring)
+        first, rest = reader.read(limit=4), reader.read()
+        bars = {key: np.concatenate([first[key], rest[key]]) for key in first}
+
+        # the same bars as from the file
+        expected = streambar.tick("tests/incremental.tape", size=2)
+        self.assertEqual(len(first['volume']), 4)
+        self.assertEqual(list(bars['symbol']), ["TEST"] * 6)
+        for name in ["first", "last", "open", "high", "low", "close", "volume", "trades", "buys", "sells"]:
+            assert_array_equal(bars[name], expected[name])
+        self.assertEqual(reader.stats(), {"position": 6, "lost": 0, "available": 0})
+
+        # a reader that joins late only gets the records still in the ring, or only new ones
+        self.assertEqual(streambar.publish("tests/incremental.tape", ("tick", 2), ring, capacity=4), 6)
+        assert_array_equal(streambar.RingReader(ring).read()['volume'], expected['volume'][2:])
+        self.assertEqual(len(streambar.RingReader(ring, history=False).read()['volume']), 0)
+
+        # the old reader keeps the ring it mapped, a missing ring is reported
+        self.assertEqual(len(reader.read()['volume']), 0)
+        os.unlink("/dev/shm" + ring)
+        self.assertRaises(TypeError, streambar.RingReader, ring)
+
+    def test_instrumentation(self):
+        # start over, and make the bars
+        streambar.instrumentation(reset=True)
+        streambar.tick("tests/incremental.tape", size=2)
+        stats = streambar.instrumentation(reset=True)
+        self.assertEqual(sorted(stats['stages'].keys()), ["add", "bar", "filter", "fits", "parse"])
+
+        # without the instrumentation compiled in, nothing is recorded
+        if not stats['enabled']:
+            self.assertEqual(stats['events'], 0)
+            self.assertEqual([stage['count'] for stage in stats['stages'].values()], [0] * 5)
+            return
+
+        # every line is parsed, every trade checked and added, the completed bars handled (the last one when it is flushed)
+        self.assertEqual(stats['events'], 13)
+        self.assertEqual({name: stage['count'] for name, stage in stats['stages'].items()}, {"parse": 13, "filter": 0, "fits": 11, "add": 11, "bar": 6})
+        self.assertGreater(stats['rate'], 0)
+        for stage in stats['stages'].values():
+            if stage['count'] > 0: self.assertTrue(stage['min'] <= stage['p50'] <= stage['p99'] <= stage['max'])
+
+        # it was reset
+        self.assertEqual(streambar.instrumentation()['events'], 0)
+
+    def test_generate(self):
+        # the same seed gives the same tape, another seed another one
+        self.assertEqual(streambar.generate(self._fname, events=20000, seed=7), 20000)
+        first = open(self._fname).read()
+        streambar.generate(self._fname, events=20000, seed=7)
+        self.assertEqual(open(self._fname).read(), first)
+        streambar.generate(self._fname, events=20000, seed=8)
+        self.assertNotEqual(open(self._fname).read(), first)
+
+        # a valid tape, the market opens with an ask and a bid and the time never goes back
+        tape = pd.read_csv(StringIO(first))
+        self.assertEqual(len(tape), 20000)
+        assert_array_equal(tape['event'].values[:2], [3, 2])
+        self.assertTrue(np.all(np.diff(tape['time'].values) >= 0))
+        self.assertTrue(set(tape['event'].unique()) <= {1, 2, 3})
+        assert_allclose(tape['price'].values * 100, np.round(tape['price'].values * 100), atol=1e-6)
+        self.assertTrue(0.2 < np.mean(tape['event'] == 1) < 0.4)
+
+        # the bars can be made from it
+        with open(self._fname, "w") as f: f.write(first)
+        self.assertEqual(sum(streambar.tick(self._fname, size=100)['trades']), np.sum(tape['event'] == 1))
+
+        # mml with several symbols and exchanges, which the demultiplexer splits
+        self.assertEqual(streambar.generate(self._fname, events=20000, mml=True, symbols=3, exchanges=2), 20000)
+        bars = streambar.demux(self._fname, ("tick", 50))
+        self.assertEqual(sorted(bars.keys()), ["SYM0", "SYM1", "SYM2"])
+
+        # a tape has only one symbol
+        self.assertRaises(TypeError, streambar.generate, self._fname, symbols=2)
+
+    def test_from_arrays(self):
+        # load the events
+        events = pd.read_csv("tests/incremental.tape")
+
+        # the same bars as from the file, from separate arrays and from a structured array
+        expected = streambar.volume("tests/incremental.tape", size=500)
+        separate = streambar.from_arrays(("volume", 500), events['event'].values, events['time'].values, events['price'].values, events['size'].values)
+        structured = streambar.from_arrays({"type": "volume", "size": 500}, events.to_records(index=False))
+
+        # check the data
+        for name in expected:
+            assert_array_equal(separate[name], expected[name])
+            assert_array_equal(structured[name], expected[name])
+
+        # missing fields are reported
+        self.assertRaises(TypeError, streambar.from_arrays, ("volume", 500), events[['time', 'price']].to_records(index=False))
+
+    def test_multitime(self):
+        # the bars of all resolutions, from a single pass
+        bars = streambar.multitime("tests/incremental.tape", [1, 2, 4])
+        self.assertEqual(sorted(bars.keys()), [1, 2, 4])
+
+        # the merged skewness keeps its sign (one third at 100, two thirds at 102.5)
+        self.assertAlmostEqual(bars[2]["skewness"][0], -np.sqrt(0.5), places=4)
+
+        # a generated tape, with many bars of every resolution
+        streambar.generate(self._fname, events=20000, seed=3)
+        bars = streambar.multitime(self._fname, [1, 5, 60])
+
+        # the same as separate time bars, also the merged statistics
+        for seconds in [1, 5, 60]:
+            expected = streambar.time(self._fname, size=seconds)
+            self.assertGreater(len(expected['volume']), 100)
+            for name in ["open", "high", "low", "close", "first", "last", "volume", "dollars", "trades", "buys", "sells", "buy_volume", "sell_volume"]:
+                assert_array_equal(bars[seconds][name], expected[name])
+            for name in ["vwap", "std"]:
+                assert_allclose(bars[seconds][name], expected[name], rtol=1e-4, atol=1e-4)
+            for name in ["skewness", "kurtosis"]:
+                assert_allclose(bars[seconds][name], expected[name], rtol=1e-2, atol=1e-2)
+
+            # the merged absolute deviation is only an upper bound
+            self.assertTrue(np.all(bars[seconds]['mad'] >= expected['mad'] - 1e-4))
+
+        # which is above the exact one for the coarser bars
+        self.assertGreater(np.sum(bars[60]['mad'] > expected['mad'] + 1e-3), 100)
+
+        # the coarser resolutions must be multiples of the finest
+        self.assertRaises(TypeError, streambar.multitime, "tests/incremental.tape", [2, 3])
+
+    def test_resample(self):
+        # bars of one second, resampled into boxes of two seconds
+        fine = streambar.time("tests/incremental.tape", size=1)
+        expected = streambar.time("tests/incremental.tape", size=2)
+        bars = streambar.resample(fine, 2000, by="time")
+
+        # the same as made from the trades
+        for name in ["open", "high", "low", "close", "first", "last", "volume", "dollars", "trades", "buys", "sells"]:
+            assert_array_equal(bars[name], expected[name])
+        for name in ["vwap", "std", "skewness", "kurtosis"]:
+            assert_allclose(bars[name], expected[name], rtol=1e-4, atol=1e-4)
+
+        # resampling resampled bars, per number of bars
+        coarse = streambar.resample(bars, 2)
+        assert_array_equal(coarse["volume"], [1000, 2600, 3000])
+        assert_allclose(coarse["vwap"], streambar.time("tests/incremental.tape", size=4)["vwap"], rtol=1e-4)
+
+        # the grouping must be known
+        self.assertRaises(TypeError, streambar.resample, fine, 2, by="volume")
+
+        # and the columns must be just as long
+        short = dict(fine)
+        short["volume"] = fine["volume"][:-1]
+        self.assertRaises(TypeError, streambar.resample, short, 2)
+
+    def test_multi(self):
+        # all bars from a single parse
+        specs = [("tick", 2), ("volume", 500), {"type": "tickimbalance", "E_T": 3, "P_b": 0.5}, {"type": "volumeruns", "T": 3, "buys": 200, "sells": 200}]
+        bars = streambar.multi("tests/small.tape", specs)
+
+        # the same bars as the separate runs
+        assert_array_equal(bars[0]['volume'], [200, 200, 200, 200, 200, 100])
+        assert_array_equal(bars[1]['volume'], [500, 500, 100])
+
+        # the information-driven bars are there as well, together covering all trades
+        self.assertEqual(bars[2]['volume'].sum(), 1100)
+        self.assertEqual(bars[3]['volume'].sum(), 1100)
+
+        # or write them to files
+        self.assertEqual(streambar.multi("tests/small.tape", specs[:1], outputs=[self._fname]), [6])
+        assert_array_equal(pd.read_csv(self._fname)['volume'].values, [200, 200, 200, 200, 200, 100])
+
+        # there must be an output per spec
+        self.assertRaises(TypeError, streambar.multi, "tests/small.tape", specs, outputs=[self._fname])
+
+    def test_index(self):
+        # the bars in a range of the day, by parsing the whole file
+        expected = streambar.tick("tests/incremental.tape", size=2, start=1003000, end=1006000)
+        self.assertEqual(expected['volume'].sum(), 400 + 500 + 600 + 700)
+
+        # index the file, with entries every other second (removed again, also when the test fails)
+        self.addCleanup(os.unlink, "tests/incremental.tape.idx")
+        self.assertGreater(streambar.index("tests/incremental.tape", interval=2000), 0)
+
+        # the same bars by seeking with the index
+        indexed = streambar.tick("tests/incremental.tape", size=2, start=1003000, end=1006000)
+        for name in expected: assert_array_equal(indexed[name], expected[name])
+
+        # an index of a tape that was written again after it is not used
+        self.addCleanup(os.unlink, self._fname + ".idx")
+        with open("tests/incremental.tape") as tape: lines = tape.readlines()
+        with open(self._fname, "w") as tape: tape.writelines(lines)
+        streambar.index(self._fname, interval=2000)
+        with open(self._fname, "w") as tape: tape.writelines(lines[:3] + lines[4:])
+        rewritten = streambar.tick(self._fname, size=2, start=1003000, end=1006000)
+        for name in expected: assert_array_equal(rewritten[name], expected[name])
+
+        # nor is a corrupt one, it falls back to parsing the whole file
+        streambar.index(self._fname, interval=2000)
+        with open(self._fname + ".idx", "r+b") as index: index.seek(31); index.write(b"\xff" * 8)
+        corrupt = streambar.tick(self._fname, size=2, start=1003000, end=1006000)
+        for name in expected: assert_array_equal(corrupt[name], expected[name])
+
+        # or a truncated one
+        streambar.index(self._fname, interval=2000)
+        os.truncate(self._fname + ".idx", 40)
+        truncated = streambar.tick(self._fname, size=2, start=1003000, end=1006000)
+        for name in expected: assert_array_equal(truncated[name], expected[name])
+
+    def test_demux(self):
+        # bars for every symbol in the file, in a single pass
+        bars = streambar.demux("tests/multi.mml", ("tick", 2))
+
+        # the filtered trades are not in there
+        self.assertEqual(sorted(bars.keys()), ["AAA", "BBB"])
+        assert_array_equal(bars["AAA"]['volume'], [300, 700, 1100, 700])
+        assert_array_equal(bars["BBB"]['volume'], [150, 350, 550, 350])
+
+        # the same bars when the symbols are spread over threads
+        threaded = streambar.demux("tests/multi.mml", ("tick", 2), threads=2)
+        for symbol in bars: assert_array_equal(threaded[symbol]['volume'], bars[symbol]['volume'])
+
+    def test_warm(self):
+        # the first day starts from the guesses, and stores its state
+        spec = {"type": "tickimbalance", "E_T": 3, "P_b": 0.5}
+        store = self._fname + ".warm"
+        cold = streambar.demux("tests/multi.mml", spec, warm=store)
+        self.assertTrue(os.path.exists(store))
+
+        # the next day starts from it, so its bars are not the cold ones
+        warm = streambar.demux("tests/multi.mml", spec, warm=store)
+        self.assertFalse(np.array_equal(warm["AAA"]["volume"], cold["AAA"]["volume"]))
+
+        # a maker starts from the same state, but only for the same symbol and bar
+        events = pd.read_csv("tests/incremental.tape")
+        maker = streambar.BarMaker(spec)
+        self.assertTrue(maker.warm(store, "AAA"))
+        self.assertFalse(maker.warm(store, "CCC"))
+        self.assertFalse(streambar.BarMaker({"type": "tickimbalance", "E_T": 4}).warm(store, "AAA"))
+
+        # and stores its own state next to the others
+        maker.process(events['event'].values, events['time'].values, events['price'].values, events['size'].values)
+        maker.flush()
+        maker.persist(store, "CCC")
+        self.assertTrue(streambar.BarMaker(spec).warm(store, "CCC"))
+        self.assertTrue(streambar.BarMaker(spec).warm(store, "BBB"))
+
+        # a store that can not be written completely does not replace the one there is
+        if os.path.exists("/dev/full"):
+            os.symlink("/dev/full", store + ".tmp")
+            self.assertRaises(TypeError, maker.persist, store, "DDD")
+            self.assertFalse(os.path.lexists(store + ".tmp"))
+            self.assertTrue(streambar.BarMaker(spec).warm(store, "CCC"))
+            self.assertFalse(streambar.BarMaker(spec).warm(store, "DDD"))
+        os.unlink(store)
+
+    def test_merge(self):
+        # split the tape in the quotes and the trades
+        events = pd.read_csv("tests/incremental.tape")
+        quotes, trades = self._fname + ".quotes", self._fname + ".trades"
+        events[events['event'] != 1].to_csv(quotes, index=False)
+        events[events['event'] == 1].to_csv(trades, index=False)
+
+        # merged back together, the quotes go first on equal times
+        self.assertEqual(streambar.merge([quotes, trades], self._fname), len(events))
+        assert_array_equal(pd.read_csv(self._fname).values, events.values)
+
+        # or straight into bars, the same as from the original
+        bars = streambar.merge([quotes, trades], spec=("tick", 2))
+        assert_array_equal(bars['volume'], streambar.tick("tests/incremental.tape", size=2)['volume'])
+        os.unlink(quotes)
+        os.unlink(trades)
+
+        # there must be somewhere to go
+        self.assertRaises(TypeError, streambar.merge, ["tests/small.tape"])
+
     def test_invalid_file(self):
         # should be 6 bars in total, with the last one being off @todo typeerror is weird but works for now I guess
         self.assertRaises(TypeError, streambar.tick, "nx", "", size=123)
@@ -139,7 +704,96 @@ class TestPerformance(unittest.TestCase):
         os.unlink(self._fname)
     
     def test_performance(self):
-        pass
+        # simulate the actions without costs
+        result = streambar.performance("tests/small.mml", "tests/actions.csv", self._fname)
+
+        # the first buy is limited by the ask size, the sells hit the bid
+        self.assertEqual(result['position'], 150)
+        self.assertEqual(result['traded'], 450)
+        self.assertEqual(result['actions'], 3)
+        self.assertAlmostEqual(result['cash'], -15005, places=2)
+        self.assertAlmostEqual(result['value'], 47.5, places=2)
+
+        # a record per action
+        df = pd.read_csv(self._fname)
+        assert_array_equal(df['requested'].values, [500, -100, -50])
+        assert_array_equal(df['filled'].values, [300, -100, -50])
+
+    def test_performance_multiple(self):
+        # second output file
+        other = self._fname + ".other"
+
+        # simulate the same actions twice, in a single pass
+        results = streambar.performance("tests/small.mml", ["tests/actions.csv", "tests/actions.csv"], [self._fname, other])
+        os.unlink(other)
+
+        # both give the same results as a single run
+        self.assertEqual(results, [streambar.performance("tests/small.mml", "tests/actions.csv", self._fname)] * 2)
+
+        # there must be an output per action file
+        self.assertRaises(TypeError, streambar.performance, "tests/small.mml", ["tests/actions.csv"], [])
+
+    def test_performance_costs(self):
+        # simulate the actions with fees and slippage
+        result = streambar.performance("tests/small.mml", "tests/actions.csv", self._fname, fee=0.01, minimum=1.0, slippage=10)
+
+        # same position, but we paid for it
+        self.assertEqual(result['position'], 150)
+        self.assertAlmostEqual(result['fees'], 5.0)
+        self.assertLess(result['value'], 47.5 - 5.0)
+
+class TestConversion(unittest.TestCase):
+    def setUp(self):
+        # create a filename
+        out = tempfile.NamedTemporaryFile(delete=False)
+        self._fname = out.name
+        out.close()
+
+    def tearDown(self):
+        # unlink the file again
+        os.unlink(self._fname)
+
+    def test_mml_to_tape_nbbo(self):
+        # every quote is passed on as it is
+        streambar.mml_to_tape("tests/nbbo.mml", self._fname, 0)
+        df = pd.read_csv(self._fname)
+        assert_array_equal(df[df['event'] == 2]['price'].values, [100.0, 100.05, 99.9, 99.8])
+
+        # the best bid over both exchanges, only when it changes
+        streambar.mml_to_tape("tests/nbbo.mml", self._fname, 0, nbbo=True)
+        df = pd.read_csv(self._fname)
+        assert_array_equal(df[df['event'] == 2]['price'].values, [100.0, 100.05, 99.9])
+        assert_array_equal(df[df['event'] == 3]['price'].values, [100.2, 100.3])
+
+        # the quotes of an exchange beyond the table are ignored, instead of overwriting exchange 1
+        lines = open("tests/nbbo.mml").readlines()
+        lines[3] = lines[3].replace("TEST,2,", "TEST,257,")
+        with open(self._fname + ".mml", "w") as f: f.writelines(lines)
+        self.addCleanup(os.unlink, self._fname + ".mml")
+        streambar.mml_to_tape(self._fname + ".mml", self._fname, 0, nbbo=True)
+        df = pd.read_csv(self._fname)
+        assert_array_equal(df[df['event'] == 2]['price'].values, [100.0, 99.9])
+
+    def test_mml_to_tape_filter(self):
+        # the default filter drops a condition and a dark pool
+        self.assertEqual(streambar.mml_to_tape("tests/small.mml", self._fname, 0), {'checked': 10, 'condition': 1, 'exchange': 1})
+
+        # accept the other condition as well, without a list of exchanges all of them are accepted
+        self.assertEqual(streambar.mml_to_tape("tests/small.mml", self._fname, 0, filter={"conditions": [0, 12]}), {'checked': 10, 'condition': 0, 'exchange': 0})
+        self.assertEqual((pd.read_csv(self._fname)['event'] == 1).sum(), 3)
+
+        # accept the dark pools for the trades only
+        self.assertEqual(streambar.mml_to_tape("tests/small.mml", self._fname, 0, filter={"conditions": [0], "blocked": [57], "trades": {"blocked": []}})['exchange'], 0)
+
+        # exchanges beyond the blocked ones are accepted, also those above the range of the lists
+        lines = open("tests/small.mml").readlines()
+        lines[3] = lines[3].replace("TEST,1,", "TEST,300,")
+        with open(self._fname + ".mml", "w") as f: f.writelines(lines)
+        self.addCleanup(os.unlink, self._fname + ".mml")
+        self.assertEqual(streambar.mml_to_tape(self._fname + ".mml", self._fname, 0), {'checked': 10, 'condition': 1, 'exchange': 1})
+
+        # the lists must hold non-negative numbers
+        self.assertRaises(TypeError, streambar.mml_to_tape, "tests/small.mml", self._fname, 0, filter={"conditions": [-1]})
 
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
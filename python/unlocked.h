@@ -0,0 +1,39 @@
+/**
+ *  Unlocked.h
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <Python.h>
+
+/**
+ *  Helper class that releases the GIL for as long as it lives, so that
+ *  other python threads can run while we are busy in C++. Nothing in
+ *  python may be touched while the object exists.
+ */
+class Unlocked
+{
+private:
+    /**
+     *  The saved thread state
+     */
+    PyThreadState *_state;
+
+public:
+    /**
+     *  Constructor, releases the GIL
+     */
+    Unlocked() : _state(PyEval_SaveThread()) {}
+
+    /**
+     *  No copying
+     */
+    Unlocked(const Unlocked &that) = delete;
+
+    /**
+     *  Destructor, takes the GIL again (also when an exception is thrown)
+     */
+    ~Unlocked() { PyEval_RestoreThread(_state); }
+};
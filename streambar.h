@@ -3,6 +3,8 @@
  *
  */
 #include <streambar/util.h>
+#include <streambar/filter.h>
+#include <streambar/tapeindex.h>
 #include <streambar/bars/timebar.h>
 #include <streambar/bars/volumebar.h>
 #include <streambar/bars/dollarbar.h>
@@ -18,8 +20,35 @@
 #include <streambar/quote.h>
 #include <streambar/bar.h>
 #include <streambar/barprinter.h>
+#include <streambar/barcolumns.h>
+#include <streambar/accumulator.h>
+#include <streambar/multitime.h>
+#include <streambar/resample.h>
+#include <streambar/snapshot.h>
+#include <streambar/warmstore.h>
+#include <streambar/follow.h>
+#include <streambar/barrecord.h>
+#include <streambar/ingest.h>
+#include <streambar/sharedring.h>
+#include <streambar/ringpublisher.h>
+#include <streambar/ringreader.h>
+#include <streambar/generator.h>
 #include <streambar/barmaker.h>
+#include <streambar/barspec.h>
+#include <streambar/fanout.h>
+#include <streambar/reorder.h>
+#include <streambar/merge.h>
+#include <streambar/tapewriter.h>
+#include <streambar/nbbo.h>
+#include <streambar/convert.h>
+#include <streambar/symboltable.h>
+#include <streambar/demux.h>
+#include <streambar/stealingpool.h>
+#include <streambar/driver.h>
 #include <streambar/eventprocessor.h>
+#include <streambar/costs.h>
+#include <streambar/strategy.h>
 #include <streambar/simulated.h>
+#include <streambar/multisimulated.h>
 #include <streambar/mmltapemaker.h>
 #include <streambar/negspreads.h>
\ No newline at end of file
@@ -0,0 +1,311 @@
+/**
+ *  Accumulator.h
+ *
+ *  The statistics of a bar (the same as the BarPrinter writes), in a form
+ *  that can be merged with the statistics of the bar after it, without
+ *  going back to the trades. The volume weighted moments are kept as sums
+ *  of powers of the deviation from the mean, that are merged pairwise.
+ *
+ *  The mean absolute deviation can not be merged exactly (it needs every
+ *  price again once the mean moves), so merged bars hold an upper bound:
+ *  the deviations of the parts, plus how far their means are from the new
+ *  mean.
+ *
+ *  Bars that were printed before can also be turned back into accumulators,
+ *  to resample them.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "quote.h"
+#include "tradeinfo.h"
+#include "bar.h"
+
+class Accumulator
+{
+public:
+    /**
+     *  Handler for the accumulated bars
+     */
+    class Handler
+    {
+    public:
+        /**
+         *  Called when a bar is fully done
+         *  @param  bar
+         */
+        virtual void onBar(const Accumulator &bar) = 0;
+
+        /**
+         *  Destructor
+         */
+        virtual ~Handler() = default;
+    };
+
+private:
+    /**
+     *  Prices of the bar
+     */
+    float _open = 0.0;
+    float _high = 0.0;
+    float _low = 0.0;
+    float _close = 0.0;
+
+    /**
+     *  Last bid/ask in the bar
+     */
+    Quote _bid;
+    Quote _ask;
+
+    /**
+     *  First and last timestamp
+     */
+    size_t _first = 0;
+    size_t _last = 0;
+
+    /**
+     *  Sizes of the bar
+     */
+    size_t _volume = 0;
+    double _dollars = 0.0;
+    size_t _trades = 0;
+
+    /**
+     *  Volume weighted mean, the sums of the powers of the deviations from
+     *  it, and the sum of the absolute deviations
+     */
+    double _mean = 0.0;
+    double _m2 = 0.0;
+    double _m3 = 0.0;
+    double _m4 = 0.0;
+    double _deviation = 0.0;
+
+    /**
+     *  Tick rule statistics
+     */
+    size_t _buys = 0;
+    size_t _sells = 0;
+    size_t _buyVolume = 0;
+    size_t _sellVolume = 0;
+
+public:
+    /**
+     *  Constructor for an empty bar
+     */
+    Accumulator() = default;
+
+    /**
+     *  Constructor for a single trade
+     *  @param  info
+     */
+    Accumulator(const TradeInfo &info) :
+        _open(info.trade().price()), _high(info.trade().price()), _low(info.trade().price()), _close(info.trade().price()),
+        _bid(info.bid()), _ask(info.ask()), _first(info.trade().time()), _last(info.trade().time()),
+        _volume(info.trade().size()), _dollars(info.trade().size() * info.trade().price()), _trades(1),
+        _mean(info.trade().price()),
+        _buys(info.tick() > 0), _sells(info.tick() < 0),
+        _buyVolume(info.tick() > 0 ? info.trade().size() : 0), _sellVolume(info.tick() < 0 ? info.trade().size() : 0) {}
+
+    /**
+     *  Constructor for all trades of a bar, the absolute deviation is exact
+     *  @param  bar
+     */
+    Accumulator(const Bar &bar)
+    {
+        // add all the trades
+        for (const auto &info : bar.trades()) add(info);
+
+        // the mean is known now, so the absolute deviation can be done exactly
+        _deviation = 0.0;
+        for (const auto &info : bar.trades()) _deviation += info.trade().size() * std::fabs(info.trade().price() - _mean);
+    }
+
+    /**
+     *  Constructor from the statistics as the BarPrinter writes them, so that
+     *  bars can be merged without their trades
+     */
+    Accumulator(float open, float high, float low, float close, const Quote &bid, const Quote &ask, size_t first, size_t last,
+                size_t volume, double dollars, size_t trades, float vwap, float stddev, float mad, float skewness, float kurtosis,
+                size_t buys, size_t sells, size_t buyVolume, size_t sellVolume) :
+        _open(open), _high(high), _low(low), _close(close), _bid(bid), _ask(ask), _first(first), _last(last),
+        _volume(volume), _dollars(dollars), _trades(trades), _mean(vwap),
+        _m2(double(stddev) * stddev * volume), _m3(double(skewness) * stddev * stddev * stddev * volume), _m4(double(kurtosis) * stddev * stddev * stddev * stddev * volume),
+        _deviation(double(mad) * volume),
+        _buys(buys), _sells(sells), _buyVolume(buyVolume), _sellVolume(sellVolume) {}
+
+    /**
+     *  Add a trade after the others
+     *  @param  info
+     */
+    void add(const TradeInfo &info)
+    {
+        // merge with the bar of just the trade
+        merge(Accumulator(info));
+    }
+
+    /**
+     *  Merge with the bar that comes after this one
+     *  @param  that
+     */
+    void merge(const Accumulator &that)
+    {
+        // nothing to merge
+        if (that._trades == 0) return;
+
+        // if we're empty, we simply become the other
+        if (_trades == 0) { *this = that; return; }
+
+        // the prices
+        _high = std::max(_high, that._high);
+        _low = std::min(_low, that._low);
+        _close = that._close;
+
+        // the last quotes and time
+        _bid = that._bid;
+        _ask = that._ask;
+        _last = that._last;
+
+        // the moments, weighted by the volumes
+        double na = _volume, nb = that._volume, n = na + nb;
+        if (n > 0)
+        {
+            // the difference between the means, and the new mean
+            double d = that._mean - _mean;
+            double mean = _mean + d * nb / n;
+
+            // the pairwise merge of the sums of the powers of the deviations
+            double m2 = _m2 + that._m2 + d * d * na * nb / n;
+            double m3 = _m3 + that._m3 + d * d * d * na * nb * (na - nb) / (n * n) + 3.0 * d * (na * that._m2 - nb * _m2) / n;
+            double m4 = _m4 + that._m4 + d * d * d * d * na * nb * (na * na - na * nb + nb * nb) / (n * n * n) + 6.0 * d * d * (na * na * that._m2 + nb * nb * _m2) / (n * n) + 4.0 * d * (na * that._m3 - nb * _m3) / n;
+
+            // the bound on the absolute deviation
+            _deviation += that._deviation + na * std::fabs(_mean - mean) + nb * std::fabs(that._mean - mean);
+
+            // store them
+            _mean = mean;
+            _m2 = m2;
+            _m3 = m3;
+            _m4 = m4;
+        }
+
+        // the sizes
+        _volume += that._volume;
+        _dollars += that._dollars;
+        _trades += that._trades;
+
+        // the tick rule statistics
+        _buys += that._buys;
+        _sells += that._sells;
+        _buyVolume += that._buyVolume;
+        _sellVolume += that._sellVolume;
+    }
+
+    /**
+     *  Whether there are no trades in the bar
+     *  @return bool
+     */
+    bool empty() const { return _trades == 0; }
+
+    /**
+     *  Prices of the bar
+     *  @return float
+     */
+    float open() const { return _open; }
+    float high() const { return _high; }
+    float low() const { return _low; }
+    float close() const { return _close; }
+
+    /**
+     *  Last bid/ask in the bar
+     *  @return Quote
+     */
+    const Quote &bid() const { return _bid; }
+    const Quote &ask() const { return _ask; }
+
+    /**
+     *  First and last timestamp
+     *  @return size_t
+     */
+    size_t first() const { return _first; }
+    size_t last() const { return _last; }
+
+    /**
+     *  Sizes of the bar
+     */
+    size_t volume() const { return _volume; }
+    double dollars() const { return _dollars; }
+    size_t trades() const { return _trades; }
+
+    /**
+     *  Volume weighted average price
+     *  @return float
+     */
+    float vwap() const { return _mean; }
+
+    /**
+     *  Volume weighted standard deviation
+     *  @return float
+     */
+    float std() const
+    {
+        // safety to prevent NaN
+        if (_m2 < 1e-6) return 0.0;
+
+        // the root of the variance
+        return std::sqrt(_m2 / _volume);
+    }
+
+    /**
+     *  Volume weighted mean absolute deviation
+     *  @return float
+     */
+    float mad() const
+    {
+        // safety to prevent NaN
+        if (_deviation < 1e-6) return 0.0;
+
+        // the average deviation
+        return _deviation / _volume;
+    }
+
+    /**
+     *  Volume weighted skewness
+     *  @return float
+     */
+    float skewness() const
+    {
+        // if there is no standard deviation, leap out
+        double deviation = std();
+        if (deviation == 0.0) return 0.0;
+
+        // the third moment, standardized
+        return _m3 / _volume / (deviation * deviation * deviation);
+    }
+
+    /**
+     *  Volume weighted kurtosis
+     *  @return float
+     */
+    float kurtosis() const
+    {
+        // if there is no standard deviation, leap out
+        double deviation = std();
+        if (deviation == 0.0) return 0.0;
+
+        // the fourth moment, standardized
+        return _m4 / _volume / (deviation * deviation * deviation * deviation);
+    }
+
+    /**
+     *  Tick rule statistics
+     *  @return size_t
+     */
+    size_t buys() const { return _buys; }
+    size_t sells() const { return _sells; }
+    size_t buyVolume() const { return _buyVolume; }
+    size_t sellVolume() const { return _sellVolume; }
+};
@@ -16,6 +16,11 @@ public:
     class Handler
     {
     public:
+        /**
+         *  Destructor, handlers are owned through this interface
+         */
+        virtual ~Handler() = default;
+
         /**
          *  Called when a bar is fully done.
          *  @param  bar
@@ -33,6 +38,14 @@ private:
      */
     std::shared_ptr<Bar> _last;
 
+    /**
+     *  Whether this is a gap, an empty time box, with the time it starts and
+     *  the last trade before it (with the quotes at the time of the gap)
+     */
+    bool _gap = false;
+    size_t _time = 0;
+    TradeInfo _carry = TradeInfo(Quote(), Quote(), Quote(), 0);
+
     /**
      *  Tick rule
      *  @param  price
@@ -56,9 +69,16 @@ private:
 public:
     /**
      *  A single bar
-     *  @param  bar     previous bar (needed for tick rule)
+     *  @param  bar     previous bar (needed for tick rule), if it is empty the one before it is used
      */
-    Bar(const std::shared_ptr<Bar> &bar = nullptr) : _last(bar) {}
+    Bar(const std::shared_ptr<Bar> &bar = nullptr) : _last(bar && bar->size() == 0 ? bar->_last : bar) {}
+
+    /**
+     *  A gap, a time box without trades
+     *  @param  time    start of the box
+     *  @param  carry   the last trade before it, with the current bid and ask
+     */
+    Bar(size_t time, const TradeInfo &carry) : _gap(true), _time(time), _carry(carry) {}
 
     /**
      *  Add to the bar
@@ -72,6 +92,22 @@ public:
         _trades.emplace_back(trade, bid, ask, tickrule(trade.price()));
     }
 
+    /**
+     *  Add a trade of which the tick is already known, to restore a bar
+     *  @param  info
+     */
+    void add(const TradeInfo &info)
+    {
+        // append to the trades
+        _trades.push_back(info);
+    }
+
+    /**
+     *  The previous bar
+     *  @return std::shared_ptr<Bar>
+     */
+    const std::shared_ptr<Bar> &last() const { return _last; }
+
     /**
      *  Get the bar length
      *  @return size_t
@@ -97,4 +133,11 @@ public:
      *  @param  size_t
      */
     int8_t tick(size_t idx) const { return _trades[idx].tick(); }
+
+    /**
+     *  Whether this is a gap, with the start of its box, and the last trade before it
+     */
+    bool gap() const { return _gap; }
+    size_t time() const { return _time; }
+    const TradeInfo &carry() const { return _carry; }
 };
\ No newline at end of file
@@ -0,0 +1,229 @@
+/**
+ *  BarColumns.h
+ *
+ *  Bar handler that keeps the bars in memory, in columnar form. It exposes
+ *  the same statistics as the BarPrinter, but instead of formatting them
+ *  to a stream every statistic is appended to its own contiguous column,
+ *  so that the columns can be handed out without copying them. It also
+ *  takes bars that were accumulated, for example by merging other bars.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <vector>
+#include "bar.h"
+#include "barprinter.h"
+#include "accumulator.h"
+
+class BarColumns : public Bar::Handler, public Accumulator::Handler
+{
+private:
+    /**
+     *  Prices of the bar
+     */
+    std::vector<float> _open;
+    std::vector<float> _high;
+    std::vector<float> _low;
+    std::vector<float> _close;
+
+    /**
+     *  Last bid/ask in the bar
+     */
+    std::vector<float> _bid_price;
+    std::vector<size_t> _bid_size;
+    std::vector<float> _ask_price;
+    std::vector<size_t> _ask_size;
+
+    /**
+     *  First and last timestamp
+     */
+    std::vector<size_t> _first;
+    std::vector<size_t> _last;
+
+    /**
+     *  Sizes of the bar
+     */
+    std::vector<size_t> _volume;
+    std::vector<double> _dollars;
+    std::vector<size_t> _trades;
+
+    /**
+     *  Volume weighted statistics
+     */
+    std::vector<float> _vwap;
+    std::vector<float> _std;
+    std::vector<float> _mad;
+    std::vector<float> _skewness;
+    std::vector<float> _kurtosis;
+
+    /**
+     *  Tick rule statistics
+     */
+    std::vector<size_t> _buys;
+    std::vector<size_t> _sells;
+    std::vector<size_t> _buy_volume;
+    std::vector<size_t> _sell_volume;
+
+    /**
+     *  Append a gap, it is flat at the last price, without volume
+     *  @param  bar
+     */
+    void gap(const std::shared_ptr<Bar> &bar)
+    {
+        // the carried trade and quotes
+        const TradeInfo &carry = bar->carry();
+        float price = carry.trade().price();
+
+        // check if there is a bid and an ask (same rule as the printer)
+        if (!carry.bid().valid() || !carry.ask().valid()) return;
+
+        // append all the columns
+        _open.push_back(price);
+        _high.push_back(price);
+        _low.push_back(price);
+        _close.push_back(price);
+        _bid_price.push_back(carry.bid().price());
+        _bid_size.push_back(carry.bid().size());
+        _ask_price.push_back(carry.ask().price());
+        _ask_size.push_back(carry.ask().size());
+        _first.push_back(bar->time());
+        _last.push_back(bar->time());
+        _volume.push_back(0);
+        _dollars.push_back(0);
+        _trades.push_back(0);
+        _vwap.push_back(price);
+        _std.push_back(0);
+        _mad.push_back(0);
+        _skewness.push_back(0);
+        _kurtosis.push_back(0);
+        _buys.push_back(0);
+        _sells.push_back(0);
+        _buy_volume.push_back(0);
+        _sell_volume.push_back(0);
+    }
+
+public:
+    /**
+     *  Constructor
+     */
+    BarColumns() = default;
+
+    /**
+     *  Destructor
+     */
+    virtual ~BarColumns() = default;
+
+    /**
+     *  Called when a bar is fully done.
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // gaps have no trades
+        if (bar && bar->gap()) return gap(bar);
+
+        // if the bar is not valid, leap out
+        if (!bar || bar->size() == 0) return;
+
+        // check if the last trade has a bid and an ask (same rule as the printer)
+        if (!bar->bid(0).valid() || !bar->ask(0).valid()) return;
+
+        // append all the columns
+        _open.push_back(BarPrinter::bar_open(bar));
+        _high.push_back(BarPrinter::bar_high(bar));
+        _low.push_back(BarPrinter::bar_low(bar));
+        _close.push_back(BarPrinter::bar_close(bar));
+        _bid_price.push_back(bar->bid(bar->size() - 1).price());
+        _bid_size.push_back(bar->bid(bar->size() - 1).size());
+        _ask_price.push_back(bar->ask(bar->size() - 1).price());
+        _ask_size.push_back(bar->ask(bar->size() - 1).size());
+        _first.push_back(BarPrinter::bar_first(bar));
+        _last.push_back(BarPrinter::bar_last(bar));
+        _volume.push_back(BarPrinter::bar_volume(bar));
+        _dollars.push_back(BarPrinter::bar_dollars(bar));
+        _trades.push_back(BarPrinter::bar_trades(bar));
+        _vwap.push_back(BarPrinter::bar_vwap(bar));
+        _std.push_back(BarPrinter::bar_vwap_std(bar));
+        _mad.push_back(BarPrinter::bar_vwap_mad(bar));
+        _skewness.push_back(BarPrinter::bar_vwap_skewness(bar));
+        _kurtosis.push_back(BarPrinter::bar_vwap_kurtosis(bar));
+        _buys.push_back(BarPrinter::bar_buys(bar));
+        _sells.push_back(BarPrinter::bar_sells(bar));
+        _buy_volume.push_back(BarPrinter::bar_buy_volume(bar));
+        _sell_volume.push_back(BarPrinter::bar_sell_volume(bar));
+    }
+
+    /**
+     *  Called when an accumulated bar is done
+     *  @param  bar
+     */
+    virtual void onBar(const Accumulator &bar) override
+    {
+        // if the bar is not valid, leap out
+        if (bar.empty()) return;
+
+        // append all the columns
+        _open.push_back(bar.open());
+        _high.push_back(bar.high());
+        _low.push_back(bar.low());
+        _close.push_back(bar.close());
+        _bid_price.push_back(bar.bid().price());
+        _bid_size.push_back(bar.bid().size());
+        _ask_price.push_back(bar.ask().price());
+        _ask_size.push_back(bar.ask().size());
+        _first.push_back(bar.first());
+        _last.push_back(bar.last());
+        _volume.push_back(bar.volume());
+        _dollars.push_back(bar.dollars());
+        _trades.push_back(bar.trades());
+        _vwap.push_back(bar.vwap());
+        _std.push_back(bar.std());
+        _mad.push_back(bar.mad());
+        _skewness.push_back(bar.skewness());
+        _kurtosis.push_back(bar.kurtosis());
+        _buys.push_back(bar.buys());
+        _sells.push_back(bar.sells());
+        _buy_volume.push_back(bar.buyVolume());
+        _sell_volume.push_back(bar.sellVolume());
+    }
+
+    /**
+     *  Visit all the columns, in the same order as the printer writes them. The
+     *  visitor is called with the name of the column and the column itself.
+     *  @param  visitor
+     */
+    template <typename Visitor>
+    void visit(Visitor &&visitor) const
+    {
+        visitor("open", _open);
+        visitor("high", _high);
+        visitor("low", _low);
+        visitor("close", _close);
+        visitor("bid_price", _bid_price);
+        visitor("bid_size", _bid_size);
+        visitor("ask_price", _ask_price);
+        visitor("ask_size", _ask_size);
+        visitor("first", _first);
+        visitor("last", _last);
+        visitor("volume", _volume);
+        visitor("dollars", _dollars);
+        visitor("trades", _trades);
+        visitor("vwap", _vwap);
+        visitor("std", _std);
+        visitor("mad", _mad);
+        visitor("skewness", _skewness);
+        visitor("kurtosis", _kurtosis);
+        visitor("buys", _buys);
+        visitor("sells", _sells);
+        visitor("buy_volume", _buy_volume);
+        visitor("sell_volume", _sell_volume);
+    }
+
+    /**
+     *  Number of bars stored
+     *  @return size_t
+     */
+    size_t number() const { return _open.size(); }
+};
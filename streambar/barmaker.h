@@ -1,6 +1,15 @@
 /**
  *  BarMaker.h
  *  
+ *  Time bars are closed as soon as the time leaves their box, either by an
+ *  event or by a heartbeat (onTime), instead of only by the next trade. If
+ *  asked for, the empty boxes are emitted as gap bars that carry the close
+ *  of the bar before them.
+ *
+ *  The state (the open bar, the quotes, the trade that the tick rule goes
+ *  on from, and the state of the processor) can be saved to a snapshot, and
+ *  loaded into a new maker with a processor of the same type and parameters.
+ *
  *  @author Michael van der Werve
  */
 
@@ -10,7 +19,11 @@
 #include "quote.h"
 #include "bars/processor.h"
 #include "eventprocessor.h"
+#include "snapshot.h"
+#include "instrument.h"
 #include <memory>
+#include <typeinfo>
+#include <stdexcept>
 
 class BarMaker : public EventProcessor
 {
@@ -37,6 +50,17 @@ private:
     Quote _ask;
     Quote _bid;
 
+    /**
+     *  Whether the empty time boxes are emitted as gaps
+     */
+    bool _gaps;
+
+    /**
+     *  The box after the last bar that was emitted (0 if there is none yet), and its last trade
+     */
+    size_t _box = 0;
+    TradeInfo _carry = TradeInfo(Quote(), Quote(), Quote(), 0);
+
     /**
      *  Helper method to reset the BarMaker.
      */
@@ -46,24 +70,66 @@ private:
         if (_bar) 
         {
             // call the handler
-            _handler->onBar(_bar);
+            {
+                Instrumentation::Probe probe(Instrumentation::Bar);
+                _handler->onBar(_bar);
+            }
 
             // and the processor
             _processor->onCompleted(*_bar);
+
+            // remember where it ended, for the gaps
+            if (_gaps && _bar->size() > 0) closed(_bar->trades().back());
         }
 
         // create a new bar
         _bar = std::make_shared<Bar>(_bar);
     }
 
+    /**
+     *  Remember the last trade of an emitted bar, for the gaps
+     *  @param  last
+     */
+    void closed(const TradeInfo &last)
+    {
+        // the interval of the boxes, nothing to remember if they are not boxed in time
+        size_t interval = _processor->interval();
+        if (interval == 0) return;
+
+        // remember the box after it, and the trade
+        _box = last.trade().time() / interval + 1;
+        _carry = last;
+    }
+
+    /**
+     *  Emit the empty boxes that are over at a time
+     *  @param  time
+     */
+    void fill(size_t time)
+    {
+        // only if we should, and a bar was emitted before
+        if (!_gaps || _box == 0) return;
+
+        // the interval of the boxes
+        size_t interval = _processor->interval();
+
+        // emit every box that is over before the box of the time
+        for (; _box < time / interval; _box++)
+        {
+            // the gap carries the last trade, with the current quotes
+            Instrumentation::Probe probe(Instrumentation::Bar);
+            _handler->onBar(std::make_shared<Bar>(_box * interval, TradeInfo(_carry.trade(), _bid, _ask, _carry.tick())));
+        }
+    }
+
 public:
     /**
      *  Constructor for the BarMaker
      *  @param  handler
      *  @param  processor
      */
-    BarMaker(Bar::Handler *handler, Processor *processor) :
-        _handler(handler), _processor(processor) {}
+    BarMaker(Bar::Handler *handler, Processor *processor, bool gaps = false) :
+        _handler(handler), _processor(processor), _gaps(gaps) {}
 
     /**
      *  Destructor, will emit the last bar if there is still an open one
@@ -88,12 +154,24 @@ public:
         // if the quote is not within 5% of it, we drop it (it is suspect), and leap out
         if (trade.price() < _bid.price() * 0.95 || trade.price() > _ask.price() * 1.05) return;
 
-        // if there is no current bar, or it does not fit in the current bar,
-        // emit the bar and reset the object (creates a new bar) 
-        if (!_bar || !_processor->fits(*_bar, trade)) reset();
+        // whether there is a current bar, and the trade fits in it
+        bool fits;
+        {
+            Instrumentation::Probe probe(Instrumentation::Fits);
+            fits = _bar && _processor->fits(*_bar, trade);
+        }
+
+        // if not, emit the bar and reset the object (creates a new bar) 
+        if (!fits) reset();
+
+        // the empty boxes before this trade
+        fill(trade.time());
 
         // add the trade
-        _bar->add(trade, _bid, _ask);
+        {
+            Instrumentation::Probe probe(Instrumentation::Add);
+            _bar->add(trade, _bid, _ask);
+        }
 
         // trade has been added to the bar
         _processor->onAdded(*_bar, trade);
@@ -107,6 +185,9 @@ public:
      */
     virtual void onBid(const Quote &bid) override
     {
+        // time has passed
+        onTime(bid.time());
+
         // simply remember
         _bid = bid;
 
@@ -126,6 +207,9 @@ public:
      */
     virtual void onAsk(const Quote &ask) override
     {
+        // time has passed
+        onTime(ask.time());
+
         // simply remember
         _ask = ask;
 
@@ -137,6 +221,126 @@ public:
         if (!_bar || !_processor->fitsAsk(*_bar, ask)) reset();
     }
 
+    /**
+     *  Process the passing of time, closes the bar if its time is over
+     *  @param  time
+     */
+    virtual void onTime(size_t time) override
+    {
+        // close the bar if it has trades, and the time is over
+        if (_bar && _bar->size() > 0 && !_processor->fitsTime(*_bar, time)) reset();
+
+        // the boxes that are over without trades
+        fill(time);
+    }
+
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    void save(Snapshot &snapshot) const
+    {
+        // the format, and the type of the processor
+        snapshot.write<uint32_t>(1);
+        snapshot.write(std::string(typeid(*_processor).name()));
+
+        // the quotes, and the state of the gaps
+        snapshot.write(_bid);
+        snapshot.write(_ask);
+        snapshot.write(_box);
+        snapshot.write(_carry);
+
+        // whether there is a bar
+        snapshot.write<bool>(_bar != nullptr);
+        if (_bar)
+        {
+            // the last trade of the previous bar, the tick rule goes on from there
+            const auto &last = _bar->last();
+            snapshot.write<bool>(last && last->size() > 0);
+            if (last && last->size() > 0) snapshot.write(last->trades().back());
+
+            // the trades of the open bar
+            snapshot.write<uint64_t>(_bar->size());
+            for (const auto &info : _bar->trades()) snapshot.write(info);
+        }
+
+        // and the processor
+        _processor->save(snapshot);
+    }
+
+    /**
+     *  Read the state from a snapshot, the state is unchanged if it fails
+     *  @param  snapshot
+     *  @throws std::runtime_error
+     */
+    void load(Snapshot &snapshot)
+    {
+        // check the format and the type of the processor
+        uint32_t version;
+        std::string type;
+        snapshot.read(version);
+        if (version != 1) throw std::runtime_error("snapshot has an unknown format");
+        snapshot.read(type);
+        if (type != typeid(*_processor).name()) throw std::runtime_error("snapshot is of another bar type");
+
+        // the quotes, and the state of the gaps, they are only ours once all is read
+        Quote bid, ask;
+        size_t box;
+        TradeInfo carry(Quote(), Quote(), Quote(), 0);
+        snapshot.read(bid);
+        snapshot.read(ask);
+        snapshot.read(box);
+        snapshot.read(carry);
+
+        // the bar, if there is one
+        bool open;
+        snapshot.read(open);
+        std::shared_ptr<Bar> bar;
+        if (open)
+        {
+            // the previous bar is just its last trade, for the tick rule
+            std::shared_ptr<Bar> last;
+            bool previous;
+            snapshot.read(previous);
+            if (previous)
+            {
+                TradeInfo info(Quote(), Quote(), Quote(), 0);
+                snapshot.read(info);
+                last = std::make_shared<Bar>();
+                last->add(info);
+            }
+
+            // the trades of the open bar
+            bar = std::make_shared<Bar>(last);
+            uint64_t size;
+            snapshot.read(size);
+            for (uint64_t i = 0; i < size; i++)
+            {
+                TradeInfo info(Quote(), Quote(), Quote(), 0);
+                snapshot.read(info);
+                bar->add(info);
+            }
+        }
+
+        // the processor, it is put back the way it was if it fails halfway
+        Snapshot backup;
+        _processor->save(backup);
+        try { _processor->load(snapshot); } catch (...) { _processor->load(backup); throw; }
+
+        // everything was read
+        _bid = bid;
+        _ask = ask;
+        _box = box;
+        _carry = carry;
+        _bar = std::move(bar);
+    }
+
+    /**
+     *  Whether the empty time boxes are emitted as gaps
+     *  @return bool
+     */
+    bool gaps() const { return _gaps; }
+
     /**
      *  Flush it
      */
@@ -10,8 +10,9 @@
 #include <cmath>
 #include <algorithm>
 #include "bar.h"
+#include "accumulator.h"
 
-class BarPrinter : public Bar::Handler
+class BarPrinter : public Bar::Handler, public Accumulator::Handler
 {
 private:
     /**
@@ -38,7 +39,7 @@ public:
      *  Free function that calculates the bar open price
      *  @param  bar
      */
-    float bar_open(const std::shared_ptr<Bar> &bar)
+    static float bar_open(const std::shared_ptr<Bar> &bar)
     {
         // first price
         return bar->trade(0).price();
@@ -48,7 +49,7 @@ public:
      *  Free function that calculates the bar high price
      *  @param bar
      */ 
-    float bar_high(const std::shared_ptr<Bar> &bar)
+    static float bar_high(const std::shared_ptr<Bar> &bar)
     {
         // current max
         float max = 0.0;
@@ -68,7 +69,7 @@ public:
      *  Free function that calculates the bar low price 
      *  @param  bar
      */
-    float bar_low(const std::shared_ptr<Bar> &bar)
+    static float bar_low(const std::shared_ptr<Bar> &bar)
     {
         // current minimum (@todo fix flt_max)
         float min = 999999999.0;
@@ -88,7 +89,7 @@ public:
      *  Free function that calculates the bar close price
      *  @param  bar
      */
-    float bar_close(const std::shared_ptr<Bar> &bar)
+    static float bar_close(const std::shared_ptr<Bar> &bar)
     {
         // last price
         return bar->trade(bar->size() - 1).price();
@@ -98,7 +99,7 @@ public:
      *  Free function that calculates the bar low price 
      *  @param  bar
      */
-    float bar_vwap(const std::shared_ptr<Bar> &bar)
+    static float bar_vwap(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t volume = 0;
@@ -124,7 +125,7 @@ public:
      *  Free function that calculates the bar standard deviation
      *  @param  bar
      */
-    float bar_vwap_std(const std::shared_ptr<Bar> &bar)
+    static float bar_vwap_std(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t volume = 0;
@@ -156,7 +157,7 @@ public:
      *  Free function that calculates the bar mean absolute deviation (MAD) 
      *  @param  bar
      */
-    float bar_vwap_mad(const std::shared_ptr<Bar> &bar)
+    static float bar_vwap_mad(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t volume = 0;
@@ -188,7 +189,7 @@ public:
      *  Free function that calculates the bar skewness
      *  @param  bar
      */
-    float bar_vwap_skewness(const std::shared_ptr<Bar> &bar)
+    static float bar_vwap_skewness(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t volume = 0;
@@ -215,8 +216,8 @@ public:
             total += info.trade().size() * pow((info.trade().price() - vwap) / std, 3);
         }
 
-        // safety to prevert NaN
-        if (total < 1e-6) return 0.0;
+        // safety to prevert NaN (the skewness may be negative)
+        if (fabs(total) < 1e-6) return 0.0;
 
         // divide by the total volume, and we get the average price
         return total / volume;
@@ -226,7 +227,7 @@ public:
      *  Free function that calculates the bar kurtosis
      *  @param  bar
      */
-    float bar_vwap_kurtosis(const std::shared_ptr<Bar> &bar)
+    static float bar_vwap_kurtosis(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t volume = 0;
@@ -264,7 +265,7 @@ public:
      *  Free function that calculates the first timestamp in the bar
      *  @param  bar
      */
-    size_t bar_first(const std::shared_ptr<Bar> &bar)
+    static size_t bar_first(const std::shared_ptr<Bar> &bar)
     {
         // first price
         return bar->trade(0).time();
@@ -274,7 +275,7 @@ public:
      *  Free function that calculates the last timestamp in the bar
      *  @param  bar
      */
-    size_t bar_last(const std::shared_ptr<Bar> &bar)
+    static size_t bar_last(const std::shared_ptr<Bar> &bar)
     {
         // last timestamp
         return bar->trade(bar->size() - 1).time();
@@ -284,7 +285,7 @@ public:
      *  Free function that calculates the bar volume
      *  @param  bar
      */
-    size_t bar_volume(const std::shared_ptr<Bar> &bar)
+    static size_t bar_volume(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t total = 0;
@@ -300,7 +301,7 @@ public:
      *  Free function that calculates the bar volume * price
      *  @param  bar
      */
-    double bar_dollars(const std::shared_ptr<Bar> &bar)
+    static double bar_dollars(const std::shared_ptr<Bar> &bar)
     {
         // total volume * price
         double total = 0;
@@ -316,7 +317,7 @@ public:
      *  Free function that calculates the number of trades in a bar
      *  @param  bar
      */
-    size_t bar_trades(const std::shared_ptr<Bar> &bar)
+    static size_t bar_trades(const std::shared_ptr<Bar> &bar)
     {
         // already exposed
         return bar->size();
@@ -325,7 +326,7 @@ public:
     /**
      *  Free function that exposes the number of buys
      */
-    size_t bar_buys(const std::shared_ptr<Bar> &bar)
+    static size_t bar_buys(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t total = 0;
@@ -344,7 +345,7 @@ public:
     /**
      *  Free function that exposes the number of sells
      */
-    size_t bar_sells(const std::shared_ptr<Bar> &bar)
+    static size_t bar_sells(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t total = 0;
@@ -363,7 +364,7 @@ public:
     /**
      *  Free function that exposes the number of buys
      */
-    size_t bar_buy_volume(const std::shared_ptr<Bar> &bar)
+    static size_t bar_buy_volume(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t total = 0;
@@ -382,7 +383,7 @@ public:
     /**
      *  Free function that exposes the number of sells
      */
-    size_t bar_sell_volume(const std::shared_ptr<Bar> &bar)
+    static size_t bar_sell_volume(const std::shared_ptr<Bar> &bar)
     {
         // total volume
         size_t total = 0;
@@ -398,12 +399,40 @@ public:
         return total;  
     }
     
+    /**
+     *  Print a gap, it is flat at the last price, without volume
+     *  @param  bar
+     */
+    void gap(const std::shared_ptr<Bar> &bar)
+    {
+        // the carried trade and quotes
+        const TradeInfo &carry = bar->carry();
+        float price = carry.trade().price();
+
+        // check if there is a bid and an ask
+        if (!carry.bid().valid() || !carry.ask().valid()) return;
+
+        // print the gap
+        _stream
+            << price << "," << price << "," << price << "," << price
+            << "," << carry.bid().price() << "," << carry.bid().size()
+            << "," << carry.ask().price() << "," << carry.ask().size()
+            << "," << bar->time() << "," << bar->time()
+            << ",0,0,0," << price << ",0,0,0,0,0,0,0,0\n";
+
+        // one more bar
+        _number++;
+    }
+
     /**
      *  Called when a bar is fully done.
      *  @param  bar
      */
     virtual void onBar(const std::shared_ptr<Bar> &bar) override
     {
+        // gaps have no trades
+        if (bar && bar->gap()) return gap(bar);
+
         // if the bar is not valid, leap out
         if (!bar || bar->size() == 0) return;
 
@@ -440,5 +469,44 @@ public:
         _number++;
     }       
 
+    /**
+     *  Called when an accumulated bar is done, for example a merge of other bars
+     *  @param  bar
+     */
+    virtual void onBar(const Accumulator &bar) override
+    {
+        // if the bar is not valid, leap out
+        if (bar.empty()) return;
+
+        // print the bar
+        _stream
+            << bar.open()
+            << "," << bar.high()
+            << "," << bar.low()
+            << "," << bar.close()
+            << "," << bar.bid().price()
+            << "," << bar.bid().size()
+            << "," << bar.ask().price()
+            << "," << bar.ask().size()
+            << "," << bar.first()
+            << "," << bar.last()
+            << "," << bar.volume()
+            << "," << bar.dollars()
+            << "," << bar.trades()
+            << "," << bar.vwap()
+            << "," << bar.std()
+            << "," << bar.mad()
+            << "," << bar.skewness()
+            << "," << bar.kurtosis()
+            << "," << bar.buys()
+            << "," << bar.sells()
+            << "," << bar.buyVolume()
+            << "," << bar.sellVolume()
+            << "\n";
+
+        // one more bar
+        _number++;
+    }
+
     size_t number() const { return _number; }
 };
\ No newline at end of file
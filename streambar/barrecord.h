@@ -0,0 +1,107 @@
+/**
+ *  BarRecord.h
+ *
+ *  Fixed layout record of a completed bar, to hand bars to other processes
+ *  without formatting them as text. All fields are in the byte order of the
+ *  machine, and the record has no padding, so a reader in another language
+ *  can unpack it with the format "<8sQQffffffffQdIIII" (on little endian).
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "accumulator.h"
+
+struct BarRecord
+{
+    /**
+     *  The symbol, padded with zeroes (not terminated if it is 8 long)
+     */
+    char symbol[8];
+
+    /**
+     *  Time of the first and the last trade
+     */
+    uint64_t first;
+    uint64_t last;
+
+    /**
+     *  The prices
+     */
+    float open;
+    float high;
+    float low;
+    float close;
+    float vwap;
+    float std;
+
+    /**
+     *  The bid and ask at the close
+     */
+    float bid;
+    float ask;
+
+    /**
+     *  The volume, and the dollars traded
+     */
+    uint64_t volume;
+    double dollars;
+
+    /**
+     *  The number of trades, and those at the ask and at the bid
+     */
+    uint32_t trades;
+    uint32_t buys;
+    uint32_t sells;
+
+    /**
+     *  Unused, keeps the size a multiple of 8
+     */
+    uint32_t reserved;
+
+    /**
+     *  Fill the record from the statistics of a bar
+     *  @param  name    the symbol, cut off at 8 characters
+     *  @param  bar
+     *  @return BarRecord
+     */
+    static BarRecord make(const std::string &name, const Accumulator &bar)
+    {
+        // all fields we do not set are zero
+        BarRecord record;
+        memset(&record, 0, sizeof(record));
+
+        // the symbol
+        memcpy(record.symbol, name.data(), std::min(name.size(), sizeof(record.symbol)));
+
+        // the times and the prices
+        record.first = bar.first();
+        record.last = bar.last();
+        record.open = bar.open();
+        record.high = bar.high();
+        record.low = bar.low();
+        record.close = bar.close();
+        record.vwap = bar.vwap();
+        record.std = bar.std();
+        record.bid = bar.bid().price();
+        record.ask = bar.ask().price();
+
+        // the volumes and the counts
+        record.volume = bar.volume();
+        record.dollars = bar.dollars();
+        record.trades = bar.trades();
+        record.buys = bar.buys();
+        record.sells = bar.sells();
+
+        // done
+        return record;
+    }
+};
+
+// the layout is part of the protocol
+static_assert(sizeof(BarRecord) == 88, "bar record must not have padding");
@@ -54,4 +54,16 @@ public:
      *  @param  max
      */
     DollarBarProcessor(double max) : _max(max) {}
+
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const override { snapshot.write(_running); }
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) override { snapshot.read(_running); }
 };
\ No newline at end of file
@@ -82,4 +82,33 @@ protected:
      *  @param  b
      */
     ImbalanceBarProcessor(EMAValue T, EMAValue b) : _T(T), _b(b) {}
+
+public:
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const override
+    {
+        // the averages, and the current bar
+        snapshot.write(_T);
+        snapshot.write(_b);
+        snapshot.write(_E_theta_T);
+        snapshot.write(_theta_T);
+        snapshot.write(_initial);
+    }
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) override
+    {
+        // the averages, and the current bar
+        snapshot.read(_T);
+        snapshot.read(_b);
+        snapshot.read(_E_theta_T);
+        snapshot.read(_theta_T);
+        snapshot.read(_initial);
+    }
 };
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "../bar.h"
 #include "../quote.h"
+#include "../snapshot.h"
 #include <memory>
 
 /**
@@ -32,6 +33,21 @@ public:
     virtual bool fitsBid(const Bar &bar, const Quote &quote) const { return true; }
     virtual bool fitsAsk(const Bar &bar, const Quote &quote) const { return true; }
 
+    /**
+     *  Function to override, whether or not the bar is still open at a time
+     *  @param  bar
+     *  @param  time
+     *  @return bool
+     */
+    virtual bool fitsTime(const Bar &bar, size_t time) const { return true; }
+
+    /**
+     *  Length of the boxes that the bars are in, for bars that are boxed in
+     *  time (0 for the others), so that empty boxes can be emitted as gaps
+     *  @return size_t
+     */
+    virtual size_t interval() const { return 0; }
+
     /**
      *  Method that is called when a quote was really added to a bar
      *  @param  trade
@@ -43,4 +59,22 @@ public:
      *  @param bar
      */
     virtual void onCompleted(const Bar &bar) {}
+
+    /**
+     *  Write the state to a snapshot (the parameters are not in it, they
+     *  come from the constructor), to override for processors with state
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const {}
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) {}
+
+    /**
+     *  Destructor, processors are owned through this interface
+     */
+    virtual ~Processor() = default;
 };
\ No newline at end of file
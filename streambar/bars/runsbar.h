@@ -90,4 +90,36 @@ public:
      */
     RunsBarProcessor(EMAValue T=100, EMAValue buys=100, EMAValue sells=100) : 
         _T(T), _buys(buys), _sells(sells) {}
+
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const override
+    {
+        // the averages, and the current bar
+        snapshot.write(_T);
+        snapshot.write(_buys);
+        snapshot.write(_sells);
+        snapshot.write(_E_theta_T);
+        snapshot.write(_bought);
+        snapshot.write(_sold);
+        snapshot.write(_initial);
+    }
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) override
+    {
+        // the averages, and the current bar
+        snapshot.read(_T);
+        snapshot.read(_buys);
+        snapshot.read(_sells);
+        snapshot.read(_E_theta_T);
+        snapshot.read(_bought);
+        snapshot.read(_sold);
+        snapshot.read(_initial);
+    }
 };
\ No newline at end of file
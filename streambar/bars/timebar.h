@@ -32,6 +32,18 @@ private:
         return bar.size() == 0 || box(trade) == _box;
     }
 
+    /**
+     *  Function to override, whether the bar is still open at a time
+     *  @param  bar
+     *  @param  time
+     *  @return bool
+     */
+    virtual bool fitsTime(const Bar &bar, size_t time) const
+    {
+        // the bar is over once the time has passed its box, earlier (stale) times are ignored
+        return bar.size() == 0 || time / (_seconds * 1000) <= _box;
+    }
+
     /**
      *  Method that is called when a quote was really added to a bar
      *  @param  trade
@@ -48,8 +60,8 @@ private:
      */
     virtual void onCompleted(const Bar &bar) 
     { 
-        // no idea which box any more now, presumably the next
-        // @todo fix addition of missing boxes
+        // no idea which box any more now, the next trade decides (the empty
+        // boxes in between are emitted as gaps by the BarMaker, if it should)
         _box = 0; 
     }
 
@@ -70,4 +82,22 @@ public:
      *  @param  seconds
      */
     TimeBarProcessor(size_t seconds) : _seconds(seconds) {}
+
+    /**
+     *  Length of the boxes
+     *  @return size_t
+     */
+    virtual size_t interval() const override { return _seconds * 1000; }
+
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const override { snapshot.write(_box); }
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) override { snapshot.read(_box); }
 };
\ No newline at end of file
@@ -58,4 +58,16 @@ public:
      *  @param  max
      */
     VolumeBarProcessor(size_t max) : _max(max) {}
+
+    /**
+     *  Write the state to a snapshot
+     *  @param  snapshot
+     */
+    virtual void save(Snapshot &snapshot) const override { snapshot.write(_running); }
+
+    /**
+     *  Read the state from a snapshot
+     *  @param  snapshot
+     */
+    virtual void load(Snapshot &snapshot) override { snapshot.read(_running); }
 };
\ No newline at end of file
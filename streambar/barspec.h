@@ -0,0 +1,152 @@
+/**
+ *  BarSpec.h
+ *
+ *  Description of a bar type and its parameters, that can be turned into
+ *  a processor. Used wherever bars are specified at runtime (for example
+ *  from Python) instead of by picking a processor class at compile time.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include "bars/processor.h"
+#include "bars/tickbar.h"
+#include "bars/volumebar.h"
+#include "bars/timebar.h"
+#include "bars/changebar.h"
+#include "bars/bachangebar.h"
+#include "bars/dollarbar.h"
+#include "bars/bichangebar.h"
+#include "bars/tickimbalancebar.h"
+#include "bars/volumeimbalancebar.h"
+#include "bars/dollarimbalancebar.h"
+#include "bars/tickrunsbar.h"
+#include "bars/volumerunsbar.h"
+#include "bars/dollarrunsbar.h"
+
+class BarSpec
+{
+private:
+    /**
+     *  The type of bar (tick, volume, time, change, bachange, bichange, dollar,
+     *  tickimbalance, volumeimbalance, dollarimbalance, tickruns, volumeruns
+     *  or dollarruns)
+     */
+    std::string _type;
+
+    /**
+     *  The parameters of the bar
+     */
+    std::map<std::string, double> _params;
+
+public:
+    /**
+     *  Constructor for a bar that only has a size
+     *  @param  type
+     *  @param  size
+     */
+    BarSpec(std::string type, double size) : _type(std::move(type))
+    {
+        // store the size
+        _params["size"] = size;
+    }
+
+    /**
+     *  Constructor for a bar with named parameters
+     *  @param  type
+     *  @param  params
+     */
+    BarSpec(std::string type, std::map<std::string, double> params) : _type(std::move(type)), _params(std::move(params)) {}
+
+    /**
+     *  Get the type
+     *  @return std::string
+     */
+    const std::string &type() const { return _type; }
+
+    /**
+     *  A key for the bar, with the type and all parameters, the same bars
+     *  have the same keys (for example to store their state under)
+     *  @return std::string
+     */
+    std::string key() const
+    {
+        // start with the type
+        std::ostringstream key;
+        key.precision(17);
+        key << _type;
+
+        // and then the parameters, they are sorted by name
+        for (const auto &param : _params) key << ',' << param.first << '=' << param.second;
+
+        // done
+        return key.str();
+    }
+
+    /**
+     *  Get a parameter, or the fallback if it was not specified
+     *  @param  name
+     *  @param  fallback
+     *  @return double
+     */
+    double param(const std::string &name, double fallback) const
+    {
+        // find the parameter
+        auto iter = _params.find(name);
+
+        // use the fallback if it is not there
+        return iter == _params.end() ? fallback : iter->second;
+    }
+
+    /**
+     *  Get an exponential moving average parameter, its factor is in the parameter
+     *  prefixed with 'alpha_' (for example T and alpha_T)
+     *  @param  name
+     *  @param  fallback
+     *  @return EMAValue
+     */
+    EMAValue ema(const std::string &name, double fallback) const
+    {
+        // construct the value
+        return EMAValue(param(name, fallback), param("alpha_" + name, 1));
+    }
+
+    /**
+     *  Create the processor for the bar
+     *  @return std::unique_ptr<Processor>
+     *  @throws std::runtime_error
+     */
+    std::unique_ptr<Processor> create() const
+    {
+        // the size is used by all the sized bars
+        double size = param("size", 100);
+
+        // check all the types
+        if (_type == "tick") return std::unique_ptr<Processor>(new TickBarProcessor(size));
+        if (_type == "volume") return std::unique_ptr<Processor>(new VolumeBarProcessor(size));
+        if (_type == "time") return std::unique_ptr<Processor>(new TimeBarProcessor(size));
+        if (_type == "change") return std::unique_ptr<Processor>(new ChangeBarProcessor(size));
+        if (_type == "bachange") return std::unique_ptr<Processor>(new BAChangeBarProcessor(size));
+        if (_type == "dollar") return std::unique_ptr<Processor>(new DollarBarProcessor(size));
+        if (_type == "bichange") return std::unique_ptr<Processor>(new BiChangeBarProcessor(param("up", size), param("down", size)));
+
+        // the imbalance bars, with the parameters of their expectations
+        if (_type == "tickimbalance") return std::unique_ptr<Processor>(new TickImbalanceBarProcessor(param("E_T", 100), param("P_b", 0.5), param("alpha_b", 0.95)));
+        if (_type == "volumeimbalance") return std::unique_ptr<Processor>(new VolumeImbalanceBarProcessor(param("E_T", 100), param("alpha_b", 0.95)));
+        if (_type == "dollarimbalance") return std::unique_ptr<Processor>(new DollarImbalanceBarProcessor(param("E_T", 100), param("alpha_b", 0.95)));
+
+        // the runs bars, the alphas default to 1 (fixed expectations) like the processors do
+        if (_type == "tickruns") return std::unique_ptr<Processor>(new TickRunsBarProcessor(ema("T", 100), ema("buys", 100), ema("sells", 100)));
+        if (_type == "volumeruns") return std::unique_ptr<Processor>(new VolumeRunsBarProcessor(ema("T", 100), ema("buys", 1000), ema("sells", 1000)));
+        if (_type == "dollarruns") return std::unique_ptr<Processor>(new DollarRunsBarProcessor(ema("T", 100), ema("buys", 100000), ema("sells", 100000)));
+
+        // unknown bar type
+        throw std::runtime_error("unknown bar type: " + _type);
+    }
+};
@@ -0,0 +1,133 @@
+/**
+ *  Convert.h
+ *
+ *  Conversion of a tape file into bars, into a handler or into an output
+ *  file. This is the path that every single conversion takes, whether it
+ *  comes from python or from the driver.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include "bar.h"
+#include "barmaker.h"
+#include "barprinter.h"
+#include "barspec.h"
+#include "fanout.h"
+#include "multitime.h"
+#include "tapeindex.h"
+#include "util.h"
+
+class Convert
+{
+public:
+    /**
+     *  Process it into a bar, passing all the bars to a handler. Only the events
+     *  between start and end are used, an index next to the input is used to
+     *  seek to the start. With gaps, the empty time boxes are emitted too.
+     */
+    static void run(Processor &processor, Bar::Handler &handler, const std::string &input, size_t start = 0, size_t end = SIZE_MAX, bool gaps = false)
+    {
+        // open the file
+        std::ifstream in(input);
+        if (!in.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+        // create the barmaker
+        BarMaker barmaker(&handler, &processor, gaps);
+
+        // seek to the start, if there is an index
+        if (start > 0) TapeIndex::seek(in, input, start, barmaker);
+
+        // process
+        Util::processTape(barmaker, in, start, end);
+
+        // flush the barmaker
+        barmaker.flush();
+    }
+
+    /**
+     *  Process it into multiple bars at once, the input is parsed only once. Every
+     *  spec has its own handler.
+     */
+    static void run(const std::vector<BarSpec> &specs, const std::vector<Bar::Handler*> &handlers, const std::string &input)
+    {
+        // open the file
+        std::ifstream in(input);
+        if (!in.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+        // the processors and the makers, the makers go first when destructed
+        std::vector<std::unique_ptr<Processor>> processors;
+        std::vector<std::unique_ptr<BarMaker>> makers;
+
+        // all the makers get the same events
+        Fanout fanout;
+
+        // create the makers
+        for (size_t i = 0; i < specs.size(); i++)
+        {
+            // create the processor and the maker
+            processors.push_back(specs[i].create());
+            makers.emplace_back(new BarMaker(handlers[i], processors.back().get()));
+
+            // the maker gets all events
+            fanout.add(makers.back().get());
+        }
+
+        // process
+        Util::processTape(fanout, in);
+
+        // flush the barmakers
+        for (auto &maker : makers) maker->flush();
+    }
+
+    /**
+     *  Process it into time bars of several resolutions at once, only the finest
+     *  is made from the trades. Every resolution has its own handler.
+     */
+    static void run(const std::vector<size_t> &seconds, const std::vector<Accumulator::Handler*> &handlers, const std::string &input, size_t start = 0, size_t end = SIZE_MAX)
+    {
+        // open the file
+        std::ifstream in(input);
+        if (!in.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+        // the bars of all resolutions
+        MultiTime multi(seconds, handlers);
+
+        // seek to the start, if there is an index
+        if (start > 0) TapeIndex::seek(in, input, start, multi);
+
+        // process
+        Util::processTape(multi, in, start, end);
+
+        // flush all resolutions
+        multi.flush();
+    }
+
+    /**
+     *  Process it into a bar
+     */
+    static size_t run(Processor &processor, const std::string &input, const std::string &output, size_t start = 0, size_t end = SIZE_MAX, bool gaps = false)
+    {
+        // open the output file
+        std::ofstream out(output, std::ios::trunc);
+        if (!out.good()) throw std::runtime_error("failed to open output file: " + std::string(strerror(errno)));
+
+        // printer
+        BarPrinter printer(out);
+
+        // convert into the printer
+        run(processor, printer, input, start, end, gaps);
+
+        // return number of bars
+        return printer.number();
+    }
+};
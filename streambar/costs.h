@@ -0,0 +1,63 @@
+/**
+ *  Costs.h
+ *
+ *  Trading costs of a simulated strategy: the fee that is paid for every
+ *  fill, and the slippage on the price that is quoted.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <algorithm>
+
+class Costs
+{
+private:
+    /**
+     *  Fee per share, and the minimum fee per fill
+     */
+    double _pershare = 0.0;
+    double _minimum = 0.0;
+
+    /**
+     *  Slippage in bips (e.g. 100 = 1%), always against us
+     */
+    double _slippage = 0.0;
+
+public:
+    /**
+     *  Constructor
+     *  @param  pershare    fee per share
+     *  @param  minimum     minimum fee per fill
+     *  @param  slippage    slippage in basis points
+     */
+    Costs(double pershare = 0.0, double minimum = 0.0, double slippage = 0.0) :
+        _pershare(pershare), _minimum(minimum), _slippage(slippage) {}
+
+    /**
+     *  The fee for a fill
+     *  @param  shares
+     *  @return double
+     */
+    double fee(size_t shares) const
+    {
+        // nothing is paid if nothing was filled
+        if (shares == 0) return 0.0;
+
+        // pay per share, but at least the minimum
+        return std::max(_minimum, _pershare * shares);
+    }
+
+    /**
+     *  The price we actually pay (when buying) or get (when selling)
+     *  @param  quoted
+     *  @param  buy
+     *  @return double
+     */
+    double price(double quoted, bool buy) const
+    {
+        // slippage moves the price against us
+        return quoted * (buy ? 1.0 + _slippage / 10000.0 : 1.0 - _slippage / 10000.0);
+    }
+};
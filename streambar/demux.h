@@ -0,0 +1,351 @@
+/**
+ *  Demux.h
+ *
+ *  Demultiplexer for MML files with more than one symbol. The symbol of
+ *  every line is looked up in a flat hash table, and the event is passed to
+ *  the processor for that symbol, which is created on first sight by a
+ *  factory. The symbols can be spread over worker threads by their hash,
+ *  every symbol always goes to the same worker so its events stay in order.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "quote.h"
+#include "eventprocessor.h"
+#include "symboltable.h"
+#include "util.h"
+
+class Demux
+{
+public:
+    /**
+     *  Factory for the processor of a new symbol, the processor is not owned
+     *  by the demultiplexer. It is always called from the thread that parses.
+     */
+    using Factory = std::function<EventProcessor*(const std::string &symbol)>;
+
+private:
+    /**
+     *  A parsed event, for a worker
+     */
+    struct Event
+    {
+        EventProcessor *processor;
+        uint8_t type;
+        Quote quote;
+    };
+
+    /**
+     *  A worker thread, with its queue of batches
+     */
+    struct Worker
+    {
+        /**
+         *  The batch that is being filled by the parser
+         */
+        std::vector<Event> batch;
+
+        /**
+         *  The batches that are ready to be processed
+         */
+        std::deque<std::vector<Event>> queue;
+
+        /**
+         *  Lock for the queue, signalled when it changes
+         */
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        /**
+         *  Whether no more batches are coming
+         */
+        bool stopped = false;
+
+        /**
+         *  The thread
+         */
+        std::thread thread;
+    };
+
+    /**
+     *  Number of events in a batch, and number of batches a worker may have queued
+     */
+    static constexpr size_t batchsize = 4096;
+    static constexpr size_t queuesize = 64;
+
+    /**
+     *  The factory for new symbols
+     */
+    Factory _factory;
+
+    /**
+     *  The symbols, with their processors and workers by index
+     */
+    SymbolTable _symbols;
+    std::vector<EventProcessor*> _processors;
+    std::vector<uint32_t> _assigned;
+
+    /**
+     *  The workers, none to process on the parsing thread
+     */
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    /**
+     *  The filter for the records
+     */
+    Filter _filter;
+
+    /**
+     *  Number of lines
+     */
+    size_t _rows = 0;
+
+    /**
+     *  Main loop of a worker
+     *  @param  worker
+     */
+    static void run(Worker *worker)
+    {
+        // the batch we're processing
+        std::vector<Event> batch;
+
+        // keep taking batches
+        while (true)
+        {
+            // take the next batch
+            {
+                std::unique_lock<std::mutex> lock(worker->mutex);
+                worker->changed.wait(lock, [worker]() { return worker->stopped || !worker->queue.empty(); });
+
+                // if there is nothing left, and we're stopped, we're done
+                if (worker->queue.empty()) return;
+
+                // take it
+                batch = std::move(worker->queue.front());
+                worker->queue.pop_front();
+            }
+
+            // there might be room for the parser now
+            worker->changed.notify_all();
+
+            // process all events
+            for (const auto &event : batch) Util::dispatch(*event.processor, event.type, event.quote, "");
+        }
+    }
+
+    /**
+     *  Hand the batch of a worker to its thread, waits if the worker is behind
+     *  @param  worker
+     */
+    static void send(Worker *worker)
+    {
+        // nothing to send
+        if (worker->batch.empty()) return;
+
+        // add to the queue
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->changed.wait(lock, [worker]() { return worker->queue.size() < queuesize; });
+            worker->queue.push_back(std::move(worker->batch));
+        }
+
+        // wake up the worker
+        worker->changed.notify_all();
+
+        // start a new batch
+        worker->batch = std::vector<Event>();
+        worker->batch.reserve(batchsize);
+    }
+
+    /**
+     *  Start all the workers
+     */
+    void start()
+    {
+        // start every thread
+        for (auto &worker : _workers)
+        {
+            worker->stopped = false;
+            worker->batch.reserve(batchsize);
+            worker->thread = std::thread(&Demux::run, worker.get());
+        }
+    }
+
+    /**
+     *  Send what is left to the workers, and wait for them to finish
+     */
+    void stop()
+    {
+        // stop every thread
+        for (auto &worker : _workers)
+        {
+            // send the last batch
+            send(worker.get());
+
+            // no more batches are coming
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopped = true;
+            }
+
+            // wake up the worker
+            worker->changed.notify_all();
+        }
+
+        // and wait for them to finish
+        for (auto &worker : _workers) worker->thread.join();
+    }
+
+    /**
+     *  Parse all lines of the stream
+     *  @param  stream
+     */
+    void parse(std::istream &stream)
+    {
+        // the line we're currently reading
+        std::string line;
+
+        // skip the first line
+        Util::skipHeader(stream);
+
+        // the quote on the line
+        Quote quote;
+
+        // get a new line from the file
+        while (std::getline(stream, line))
+        {
+            // safety for empty lines
+            if (line.size() == 0) continue;
+
+            // extra row!
+            _rows++;
+
+            // parse the line, it may be filtered out
+            uint8_t type = Util::parse(line.c_str(), quote, _filter);
+            if (type == 0) continue;
+
+            // the symbol is the second element
+            const char *symbol = line.c_str() + 2;
+            size_t size = strchr(symbol, ',') - symbol;
+
+            // find the symbol, or add it
+            size_t index = _symbols.find(symbol, size);
+            if (index == SymbolTable::npos) index = add(symbol, size);
+
+            // without workers we process right away
+            if (_workers.empty()) { Util::dispatch(*_processors[index], type, quote, line.c_str()); continue; }
+
+            // otherwise it goes in the batch for the worker
+            Worker *worker = _workers[_assigned[index]].get();
+            worker->batch.push_back(Event{ _processors[index], type, quote });
+
+            // send it if the batch is full
+            if (worker->batch.size() >= batchsize) send(worker);
+        }
+    }
+
+    /**
+     *  Add a new symbol
+     *  @param  symbol
+     *  @param  size
+     *  @return size_t  the index
+     */
+    size_t add(const char *symbol, size_t size)
+    {
+        // add to the table
+        size_t index = _symbols.insert(symbol, size);
+
+        // create the processor, and assign a worker by the hash
+        _processors.push_back(_factory(_symbols.name(index)));
+        _assigned.push_back(_workers.empty() ? 0 : SymbolTable::hash(symbol, size) % _workers.size());
+
+        // the index
+        return index;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  factory     creates the processor for every new symbol
+     *  @param  threads     number of worker threads, 0 to process on the parsing thread
+     *  @param  filter      filter for the records
+     */
+    Demux(Factory factory, size_t threads = 0, Filter filter = Filter()) : _factory(std::move(factory)), _filter(std::move(filter))
+    {
+        // create the workers
+        for (size_t i = 0; i < threads; i++) _workers.emplace_back(new Worker());
+    }
+
+    /**
+     *  No copying
+     */
+    Demux(const Demux &that) = delete;
+
+    /**
+     *  Process an MML file, when this returns all events have been passed on
+     *  @param  stream
+     *  @throws std::runtime_error  if the factory throws
+     */
+    void process(std::istream &stream)
+    {
+        // start the workers
+        start();
+
+        // parse, the workers have to be stopped in any case
+        try
+        {
+            parse(stream);
+        }
+        catch (...)
+        {
+            stop();
+            throw;
+        }
+
+        // wait for the workers
+        stop();
+    }
+
+    /**
+     *  Number of symbols
+     *  @return size_t
+     */
+    size_t size() const { return _symbols.size(); }
+
+    /**
+     *  The name of a symbol
+     *  @param  index
+     *  @return std::string
+     */
+    const std::string &symbol(size_t index) const { return _symbols.name(index); }
+
+    /**
+     *  The processor of a symbol
+     *  @param  index
+     *  @return EventProcessor
+     */
+    EventProcessor *processor(size_t index) const { return _processors[index]; }
+
+    /**
+     *  Number of lines processed
+     *  @return size_t
+     */
+    size_t rows() const { return _rows; }
+
+    /**
+     *  The filter, with the number of records it dropped
+     *  @return Filter
+     */
+    const Filter &filter() const { return _filter; }
+};
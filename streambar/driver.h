@@ -0,0 +1,229 @@
+/**
+ *  Driver.h
+ *
+ *  Runs a whole manifest of conversions on a work-stealing pool. The tasks
+ *  are ordered by the size of their input, largest first, so the long
+ *  symbol-days start right away and the small ones fill up the tail. Every
+ *  task records how long it took and which worker ran it.
+ *
+ *  A manifest has a task per line, 'input,output,type,parameters...', where
+ *  a parameter is either 'name=value' or a plain number for the size:
+ *
+ *      SPY.tape,SPY.csv,volume,50000
+ *      ABC.tape,ABC.csv,tickimbalance,E_T=100,P_b=0.5
+ *
+ *  Empty lines and lines that start with a '#' are skipped.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include "barspec.h"
+#include "convert.h"
+#include "stealingpool.h"
+
+class Driver
+{
+public:
+    /**
+     *  A single conversion, and its results after the run
+     */
+    struct Task
+    {
+        std::string input;
+        std::string output;
+        BarSpec spec;
+
+        /**
+         *  Size of the input in bytes, used for the ordering
+         */
+        size_t bytes = 0;
+
+        /**
+         *  Number of bars, seconds it took and the worker that ran it
+         */
+        size_t bars = 0;
+        double seconds = 0.0;
+        size_t worker = 0;
+
+        /**
+         *  The error, if it failed
+         */
+        std::string error;
+
+        /**
+         *  Constructor
+         *  @param  input
+         *  @param  output
+         *  @param  spec
+         */
+        Task(std::string input, std::string output, BarSpec spec) : input(std::move(input)), output(std::move(output)), spec(std::move(spec)) {}
+    };
+
+private:
+    /**
+     *  The tasks, in the order of the manifest
+     */
+    std::vector<Task> _tasks;
+
+    /**
+     *  Number of tasks that were stolen, and the seconds the whole run took
+     */
+    size_t _stolen = 0;
+    double _seconds = 0.0;
+
+    /**
+     *  Parse a line of the manifest
+     *  @param  line
+     *  @throws std::runtime_error
+     */
+    void parse(const std::string &line)
+    {
+        // all the fields
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        for (std::string field; std::getline(stream, field, ',');) fields.push_back(field);
+
+        // at least the input, the output and the type
+        if (fields.size() < 3) throw std::runtime_error("incorrect task: " + line);
+
+        // the parameters
+        std::map<std::string, double> params;
+        for (size_t i = 3; i < fields.size(); i++)
+        {
+            // find the name, a plain number is the size
+            size_t equals = fields[i].find('=');
+            if (equals == std::string::npos) params["size"] = atof(fields[i].c_str());
+            else params[fields[i].substr(0, equals)] = atof(fields[i].c_str() + equals + 1);
+        }
+
+        // add the task
+        add(fields[0], fields[1], BarSpec(fields[2], std::move(params)));
+    }
+
+public:
+    /**
+     *  Constructor
+     */
+    Driver() = default;
+
+    /**
+     *  Add a task
+     *  @param  input
+     *  @param  output
+     *  @param  spec
+     */
+    void add(const std::string &input, const std::string &output, const BarSpec &spec) { _tasks.emplace_back(input, output, spec); }
+
+    /**
+     *  Add all tasks of a manifest
+     *  @param  manifest
+     *  @throws std::runtime_error
+     */
+    void load(std::istream &manifest)
+    {
+        // every line is a task
+        for (std::string line; std::getline(manifest, line);)
+        {
+            // skip the empty lines and the comments
+            if (line.empty() || line[0] == '#') continue;
+
+            // parse the task
+            parse(line);
+        }
+    }
+
+    /**
+     *  Run all the tasks, the errors are stored in the tasks
+     *  @param  threads     number of threads, 0 to use all cores
+     */
+    void run(size_t threads = 0)
+    {
+        // start of the run
+        auto start = std::chrono::steady_clock::now();
+
+        // the size of every input
+        for (auto &task : _tasks)
+        {
+            // inputs that can not be opened are simply tried last, they fail right away
+            std::ifstream in(task.input, std::ios::binary | std::ios::ate);
+            task.bytes = in.good() ? static_cast<size_t>(in.tellg()) : 0;
+        }
+
+        // the order of the tasks, largest first
+        std::vector<size_t> order(_tasks.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return _tasks[a].bytes > _tasks[b].bytes; });
+
+        // the work for the pool
+        std::vector<StealingPool::Task> work;
+        for (auto index : order) work.push_back([this, index](size_t worker) {
+            // the task to run
+            Task &task = _tasks[index];
+
+            // the start of the task
+            auto start = std::chrono::steady_clock::now();
+
+            // errors may not leave the worker
+            try
+            {
+                // create the processor and convert
+                auto processor = task.spec.create();
+                task.bars = Convert::run(*processor, task.input, task.output);
+            }
+            catch (const std::exception &e)
+            {
+                // remember the error
+                task.error = task.input + ": " + e.what();
+            }
+
+            // record how long it took, and where
+            task.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            task.worker = worker;
+        });
+
+        // run everything
+        StealingPool pool(threads);
+        pool.run(std::move(work));
+
+        // the totals
+        _stolen = pool.stolen();
+        _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     *  Write the statistics of every task, as csv
+     *  @param  stream
+     */
+    void report(std::ostream &stream) const
+    {
+        // the header
+        stream << "input,output,bytes,bars,seconds,worker,error\n";
+
+        // every task
+        for (const auto &task : _tasks) stream << task.input << "," << task.output << "," << task.bytes << "," << task.bars << "," << task.seconds << "," << task.worker << "," << task.error << "\n";
+    }
+
+    /**
+     *  The tasks, in the order they were added
+     *  @return std::vector<Task>
+     */
+    const std::vector<Task> &tasks() const { return _tasks; }
+
+    /**
+     *  Number of tasks that were stolen, and the seconds the whole run took
+     */
+    size_t stolen() const { return _stolen; }
+    double seconds() const { return _seconds; }
+};
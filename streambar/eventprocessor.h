@@ -30,4 +30,10 @@ public:
      *  @param size
      */
     virtual void onAsk(const Quote &ask) = 0;
+
+    /**
+     *  Process the passing of time (a heartbeat), nothing happened up to this time
+     *  @param time
+     */
+    virtual void onTime(size_t time) {}
 };
\ No newline at end of file
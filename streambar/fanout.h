@@ -0,0 +1,82 @@
+/**
+ *  Fanout.h
+ *
+ *  Event processor that passes every event on to a number of other event
+ *  processors, so that a single parse of the input can feed any number of
+ *  bar makers.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <vector>
+#include "quote.h"
+#include "eventprocessor.h"
+
+class Fanout : public EventProcessor
+{
+private:
+    /**
+     *  The processors we pass the events to (not owned)
+     */
+    std::vector<EventProcessor*> _processors;
+
+public:
+    /**
+     *  Constructor
+     */
+    Fanout() = default;
+
+    /**
+     *  Constructor with the processors
+     *  @param  processors
+     */
+    Fanout(std::vector<EventProcessor*> processors) : _processors(std::move(processors)) {}
+
+    /**
+     *  Add a processor
+     *  @param  processor
+     */
+    void add(EventProcessor *processor) { _processors.push_back(processor); }
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override
+    {
+        // pass on to all processors
+        for (auto *processor : _processors) processor->onTrade(trade);
+    }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override
+    {
+        // pass on to all processors
+        for (auto *processor : _processors) processor->onBid(bid);
+    }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override
+    {
+        // pass on to all processors
+        for (auto *processor : _processors) processor->onAsk(ask);
+    }
+
+    /**
+     *  Process the passing of time
+     *  @param  time
+     */
+    virtual void onTime(size_t time) override
+    {
+        // pass on to all processors
+        for (auto *processor : _processors) processor->onTime(time);
+    }
+};
@@ -0,0 +1,202 @@
+/**
+ *  Filter.h
+ *
+ *  Filter for the records of an MML file, on their condition and on the
+ *  exchange they are from. Every record type (trade, bid, ask) has its own
+ *  rule, which is compiled into bitsets when the filter is constructed, so
+ *  checking a record is a lookup per field. The records that are dropped
+ *  are counted per reason.
+ *
+ *  The default filter is the one that was always used, it only accepts the
+ *  conditions 0, 95 and 115, and drops the dark pools (57, 58 and 59).
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <bitset>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include "instrument.h"
+
+class Filter
+{
+public:
+    /**
+     *  The rule for a record type, as lists
+     */
+    struct Rule
+    {
+        /**
+         *  The accepted conditions, all of them if empty
+         */
+        std::vector<unsigned> conditions;
+
+        /**
+         *  The accepted exchanges, all of them if empty
+         */
+        std::vector<unsigned> exchanges;
+
+        /**
+         *  The exchanges that are dropped, even if they are accepted above
+         */
+        std::vector<unsigned> blocked;
+    };
+
+    /**
+     *  The reasons to drop a record
+     */
+    enum Reason { Condition = 0, Exchange = 1, Reasons = 2 };
+
+private:
+    /**
+     *  Number of values in a bitset, larger values are only accepted if everything is
+     */
+    static constexpr size_t values = 256;
+
+    /**
+     *  A compiled rule
+     */
+    struct Compiled
+    {
+        std::bitset<values> conditions;
+        std::bitset<values> exchanges;
+        bool anycondition;
+        bool anyexchange;
+    };
+
+    /**
+     *  The compiled rules, by record type (1 = trade, 2 = bid, 3 = ask)
+     */
+    std::array<Compiled, 4> _rules;
+
+    /**
+     *  Number of records that were checked, and the number dropped per reason
+     */
+    size_t _checked = 0;
+    std::array<size_t, Reasons> _dropped{};
+
+    /**
+     *  Compile a rule
+     *  @param  rule
+     *  @return Compiled
+     */
+    static Compiled compile(const Rule &rule)
+    {
+        // the result
+        Compiled result;
+
+        // without a list, everything is accepted
+        result.anycondition = rule.conditions.empty();
+        result.anyexchange = rule.exchanges.empty();
+
+        // set the accepted conditions
+        if (result.anycondition) result.conditions.set();
+        for (auto condition : rule.conditions) if (condition < values) result.conditions.set(condition);
+
+        // set the accepted exchanges, and remove the blocked ones
+        if (rule.exchanges.empty()) result.exchanges.set();
+        for (auto exchange : rule.exchanges) if (exchange < values) result.exchanges.set(exchange);
+        for (auto exchange : rule.blocked) if (exchange < values) result.exchanges.reset(exchange);
+
+        // done
+        return result;
+    }
+
+    /**
+     *  Check a value against a bitset
+     *  @param  bits
+     *  @param  any     whether values outside the bitset are accepted
+     *  @param  value
+     *  @return bool
+     */
+    static bool test(const std::bitset<values> &bits, bool any, int value)
+    {
+        // out of range is only accepted if anything is
+        return value >= 0 && static_cast<size_t>(value) < values ? bits[value] : any;
+    }
+
+public:
+    /**
+     *  Constructor for the default filter
+     */
+    Filter() : Filter(Rule{ { 0, 95, 115 }, {}, { 57, 58, 59 } }) {}
+
+    /**
+     *  Constructor with the same rule for every record type
+     *  @param  rule
+     */
+    Filter(const Rule &rule) : Filter(rule, rule, rule) {}
+
+    /**
+     *  Constructor with a rule per record type
+     *  @param  trades
+     *  @param  bids
+     *  @param  asks
+     */
+    Filter(const Rule &trades, const Rule &bids, const Rule &asks)
+    {
+        // compile the rules, unknown types are always passed on
+        _rules[0] = compile(Rule());
+        _rules[1] = compile(trades);
+        _rules[2] = compile(bids);
+        _rules[3] = compile(asks);
+    }
+
+    /**
+     *  A filter that accepts everything
+     *  @return Filter
+     */
+    static Filter all() { return Filter(Rule()); }
+
+    /**
+     *  Check a record, and count it if it is dropped
+     *  @param  type
+     *  @param  condition
+     *  @param  exchange
+     *  @return bool    whether it is accepted
+     */
+    bool accept(uint8_t type, int condition, int exchange)
+    {
+        // time the filtering
+        Instrumentation::Probe probe(Instrumentation::Filter);
+
+        // the rule for the type
+        const Compiled &rule = _rules[type < _rules.size() ? type : 0];
+
+        // one more checked
+        _checked++;
+
+        // check the condition, and the exchange
+        if (!test(rule.conditions, rule.anycondition, condition)) { _dropped[Condition]++; return false; }
+        if (!test(rule.exchanges, rule.anyexchange, exchange)) { _dropped[Exchange]++; return false; }
+
+        // accepted
+        return true;
+    }
+
+    /**
+     *  Number of records that were checked
+     *  @return size_t
+     */
+    size_t checked() const { return _checked; }
+
+    /**
+     *  Number of records dropped for a reason, or in total
+     *  @param  reason
+     *  @return size_t
+     */
+    size_t dropped(Reason reason) const { return _dropped[reason]; }
+    size_t dropped() const { return _dropped[Condition] + _dropped[Exchange]; }
+
+    /**
+     *  Reset the counters
+     */
+    void reset()
+    {
+        _checked = 0;
+        _dropped.fill(0);
+    }
+};
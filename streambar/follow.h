@@ -0,0 +1,229 @@
+/**
+ *  Follow.h
+ *
+ *  Follows a tape (or MML) file that is still being written, like tail -f.
+ *  The file is kept open, and every poll only parses the complete lines
+ *  that were appended since the previous one, a line that is only partly
+ *  written is kept until the rest of it arrives. The events go to the same
+ *  event processor every time, so its state (the open bar) is kept over
+ *  the increments. Waiting for the file to grow is done with inotify, so
+ *  nothing runs while there is nothing new.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "quote.h"
+#include "eventprocessor.h"
+#include "filter.h"
+#include "tapeindex.h"
+#include "util.h"
+
+class Follow
+{
+private:
+    /**
+     *  The file, and the inotify instance that watches it (-1 without inotify)
+     */
+    int _fd;
+    int _inotify = -1;
+
+    /**
+     *  Format of the file, and the filter for the mml records
+     */
+    TapeIndex::Format _format;
+    Filter _filter;
+
+    /**
+     *  Bytes that were read, but are not a complete line yet
+     */
+    std::string _buffer;
+
+    /**
+     *  Number of bytes read from the file
+     */
+    size_t _offset = 0;
+
+    /**
+     *  Whether the header still has to be skipped
+     */
+    bool _header = true;
+
+    /**
+     *  Number of events passed on
+     */
+    size_t _events = 0;
+
+    /**
+     *  Milliseconds between two looks at the file, without inotify
+     */
+    static constexpr int interval = 50;
+
+    /**
+     *  Parse the complete lines in the buffer
+     *  @param  processor
+     *  @return size_t      number of events
+     */
+    size_t parse(EventProcessor &processor)
+    {
+        // the events in this call
+        size_t events = 0;
+
+        // the quote on the line
+        Quote quote;
+
+        // all complete lines
+        size_t start = 0;
+        for (size_t end = _buffer.find('\n'); end != std::string::npos; start = end + 1, end = _buffer.find('\n', start))
+        {
+            // terminate the line in place
+            char *line = &_buffer[start];
+            _buffer[end] = '\0';
+
+            // the first line is the header, and skip empty lines
+            if (_header) { _header = false; continue; }
+            if (end == start || (end == start + 1 && *line == '\r')) continue;
+
+            // parse in the right format, mml records may be filtered out
+            uint8_t type = _format == TapeIndex::Tape ? Util::parseTape(line, quote) : Util::parse(line, quote, _filter);
+            if (type == 0) continue;
+
+            // pass it on
+            Util::dispatch(processor, type, quote, line);
+            events++;
+        }
+
+        // keep the partial line
+        _buffer.erase(0, start);
+
+        // done
+        _events += events;
+        return events;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  path
+     *  @param  format  format of the file
+     *  @param  filter  filter for the mml records
+     *  @throws std::runtime_error
+     */
+    Follow(const std::string &path, TapeIndex::Format format = TapeIndex::Tape, Filter filter = Filter()) : _format(format), _filter(std::move(filter))
+    {
+        // open the file
+        _fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (_fd < 0) throw std::runtime_error("failed to open input file: " + path + ": " + std::string(strerror(errno)));
+
+#ifdef __linux__
+        // watch it for changes, without inotify we simply sleep while waiting
+        _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_inotify >= 0 && inotify_add_watch(_inotify, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) { close(_inotify); _inotify = -1; }
+#endif
+    }
+
+    /**
+     *  No copying
+     */
+    Follow(const Follow &that) = delete;
+
+    /**
+     *  Destructor
+     */
+    virtual ~Follow()
+    {
+        // close the watch and the file
+        if (_inotify >= 0) close(_inotify);
+        close(_fd);
+    }
+
+    /**
+     *  Parse everything that was appended since the last poll
+     *  @param  processor
+     *  @return size_t      number of events passed on
+     *  @throws std::runtime_error  if the file was truncated
+     */
+    size_t poll(EventProcessor &processor)
+    {
+        // if the file became smaller, we can not go on from where we were
+        struct stat info;
+        if (fstat(_fd, &info) == 0 && static_cast<size_t>(info.st_size) < _offset) throw std::runtime_error("input file was truncated");
+
+        // the events in this call
+        size_t events = 0;
+
+        // read until there is nothing more
+        char chunk[65536];
+        while (true)
+        {
+            // read a chunk
+            ssize_t size = read(_fd, chunk, sizeof(chunk));
+            if (size < 0 && errno == EINTR) continue;
+            if (size < 0) throw std::runtime_error("failed to read input file: " + std::string(strerror(errno)));
+            if (size == 0) return events;
+
+            // add it, and parse the lines that are complete
+            _offset += size;
+            _buffer.append(chunk, size);
+            events += parse(processor);
+        }
+    }
+
+    /**
+     *  Wait until the file changed, without inotify it only sleeps for a
+     *  short while (at most the timeout), after which the caller has to look
+     *  @param  timeout     milliseconds, -1 to wait forever
+     *  @return bool        whether the file changed (or might have, without inotify)
+     */
+    bool wait(int timeout)
+    {
+        // without inotify, we sleep and have to look
+        if (_inotify < 0) { std::this_thread::sleep_for(std::chrono::milliseconds(timeout < 0 ? interval : std::min(timeout, interval))); return true; }
+
+        // wait for an event
+        struct pollfd fd = { _inotify, POLLIN, 0 };
+        int result = ::poll(&fd, 1, timeout);
+        if (result <= 0) return false;
+
+        // drain the events, we only need to know that something happened
+        char events[4096];
+        while (read(_inotify, events, sizeof(events)) > 0) {}
+
+        // something changed
+        return true;
+    }
+
+    /**
+     *  Bytes read from the file, and bytes in a partial line
+     *  @return size_t
+     */
+    size_t offset() const { return _offset; }
+    size_t pending() const { return _buffer.size(); }
+
+    /**
+     *  Number of events passed on
+     *  @return size_t
+     */
+    size_t events() const { return _events; }
+
+    /**
+     *  The filter, with the number of records it dropped
+     *  @return Filter
+     */
+    const Filter &filter() const { return _filter; }
+};
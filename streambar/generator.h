@@ -0,0 +1,581 @@
+/**
+ *  Generator.h
+ *
+ *  Generator of synthetic, but realistic, tapes and MML files, to test and
+ *  benchmark with when the real ones can not be used. The same parameters
+ *  (and seed) always give the same events.
+ *
+ *  The events arrive as a Poisson process, that now and then goes into a
+ *  burst in which they arrive many times faster. The price of every symbol
+ *  is a random walk in ticks, scaled to the volatility of a day, with a
+ *  spread of a few ticks that changes every now and then. Quotes are in
+ *  round lots, trades are at the bid or the ask and are often odd lots.
+ *
+ *  Events are written straight into a buffer without printf, so that files
+ *  of billions of events can be written at hundreds of megabytes a second.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include "quote.h"
+#include "eventprocessor.h"
+#include "tapeindex.h"
+#include "util.h"
+
+class Generator
+{
+public:
+    /**
+     *  The parameters
+     */
+    struct Params
+    {
+        /**
+         *  The seed, and the number of events (over all symbols)
+         */
+        uint64_t seed = 1;
+        size_t events = 1000000;
+
+        /**
+         *  The number of symbols, only MML files can have more than one
+         */
+        size_t symbols = 1;
+
+        /**
+         *  The number of exchanges the events come from (in MML)
+         */
+        size_t exchanges = 1;
+
+        /**
+         *  The start of the day and its length, in milliseconds
+         */
+        size_t start = 34200000;
+        size_t duration = 23400000;
+
+        /**
+         *  The first price, the number of decimals, and the tick in units
+         *  of the last decimal
+         */
+        double price = 100.0;
+        unsigned decimals = 2;
+        unsigned tick = 1;
+
+        /**
+         *  The volatility of the price over the day, as a fraction
+         */
+        double volatility = 0.02;
+
+        /**
+         *  The fraction of the events that are trades
+         */
+        double trades = 0.3;
+
+        /**
+         *  The average spread in ticks, at least one
+         */
+        double spread = 1.5;
+
+        /**
+         *  The round lot, and the fraction of the trades that are odd lots
+         */
+        size_t lot = 100;
+        double odd = 0.5;
+
+        /**
+         *  The chance per event that a burst starts, the average number of
+         *  events in a burst, and how many times faster they arrive
+         */
+        double bursts = 0.0005;
+        double length = 500;
+        double intensity = 20;
+
+        /**
+         *  The fraction of the trades with a condition that the default filter drops (in MML)
+         */
+        double conditions = 0.0;
+    };
+
+    /**
+     *  An event
+     */
+    struct Event
+    {
+        /**
+         *  The type, 1 trade, 2 bid and 3 ask
+         */
+        uint8_t type;
+
+        /**
+         *  The exchange, and the condition
+         */
+        uint8_t exchange;
+        uint8_t condition;
+
+        /**
+         *  The symbol, by index, and the number of the event
+         */
+        size_t symbol;
+        uint64_t sequence;
+
+        /**
+         *  The time in microseconds, the price in units of the last decimal, and the size
+         */
+        uint64_t time;
+        int64_t price;
+        size_t size;
+    };
+
+private:
+    /**
+     *  The state of a symbol
+     */
+    struct Symbol
+    {
+        /**
+         *  The bid, and the spread in ticks
+         */
+        int64_t bid;
+        int64_t spread;
+
+        /**
+         *  The quotes that still have to be sent before the symbol trades
+         */
+        int opening = 2;
+    };
+
+    /**
+     *  The parameters
+     */
+    Params _params;
+
+    /**
+     *  The state of the random numbers (xoshiro256**)
+     */
+    uint64_t _state[4];
+
+    /**
+     *  The symbols, and their names
+     */
+    std::vector<Symbol> _symbols;
+    std::vector<std::string> _names;
+
+    /**
+     *  The clock in microseconds since the start, and the rate of the
+     *  events per microsecond outside a burst
+     */
+    double _clock = 0.0;
+    double _rate;
+
+    /**
+     *  Events left in the burst
+     */
+    size_t _burst = 0;
+
+    /**
+     *  Chance that the price moves at an event, and by how many ticks
+     */
+    double _move;
+    int64_t _step;
+
+    /**
+     *  Number of events generated
+     */
+    size_t _count = 0;
+
+    /**
+     *  The units in a whole price
+     */
+    int64_t _scale = 1;
+
+    /**
+     *  The next random number
+     *  @return uint64_t
+     */
+    uint64_t random()
+    {
+        // xoshiro256**
+        uint64_t result = rotate(_state[1] * 5, 7) * 9;
+        uint64_t t = _state[1] << 17;
+        _state[2] ^= _state[0];
+        _state[3] ^= _state[1];
+        _state[1] ^= _state[2];
+        _state[0] ^= _state[3];
+        _state[2] ^= t;
+        _state[3] = rotate(_state[3], 45);
+        return result;
+    }
+
+    /**
+     *  Rotate left
+     *  @param  value
+     *  @param  bits
+     *  @return uint64_t
+     */
+    static uint64_t rotate(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+    /**
+     *  A random number below a limit (that fits in 32 bits)
+     *  @param  limit
+     *  @return size_t
+     */
+    size_t below(size_t limit) { return ((random() >> 32) * limit) >> 32; }
+
+    /**
+     *  A uniform number in (0, 1]
+     *  @return double
+     */
+    double uniform() { return ((random() >> 11) + 1) * (1.0 / 9007199254740992.0); }
+
+    /**
+     *  A geometric number (0, 1, 2...) with a mean
+     *  @param  mean
+     *  @return size_t
+     */
+    size_t geometric(double mean)
+    {
+        // nothing to draw without a mean
+        if (mean <= 0.0) return 0;
+
+        // invert the distribution
+        return std::floor(std::log(uniform()) / std::log(mean / (mean + 1)));
+    }
+
+    /**
+     *  A geometric number with a mean of one, from the bits (half of them
+     *  are 0, a quarter 1, and so on)
+     *  @return size_t
+     */
+    size_t halving() { return __builtin_ctzll(random() | (uint64_t(1) << 32)); }
+
+    /**
+     *  Write a number
+     *  @param  output
+     *  @param  value
+     *  @param  width   minimum number of digits
+     *  @return char*   after the number
+     */
+    static char *digits(char *output, uint64_t value, unsigned width = 1)
+    {
+        // the pairs of digits
+        static const char pairs[] =
+            "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+            "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+        // the number of digits
+        unsigned length = 1;
+        for (uint64_t rest = value; rest >= 10 && length < 20; rest /= 10) length++;
+        length = std::max(length, width);
+
+        // write them from the back, two at a time
+        char *position = output + length;
+        while (value >= 100) { unsigned pair = value % 100 * 2; value /= 100; *--position = pairs[pair + 1]; *--position = pairs[pair]; }
+        if (value >= 10) { *--position = pairs[value * 2 + 1]; *--position = pairs[value * 2]; }
+        else *--position = '0' + value;
+
+        // pad with zeroes
+        while (position > output) *--position = '0';
+        return output + length;
+    }
+
+    /**
+     *  Write a price
+     *  @param  output
+     *  @param  price   in units of the last decimal
+     *  @return char*   after the price
+     */
+    char *price(char *output, int64_t price) const
+    {
+        // the whole part
+        output = digits(output, price / _scale);
+
+        // and the decimals
+        if (_params.decimals == 0) return output;
+        *output++ = '.';
+        return digits(output, price % _scale, _params.decimals);
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  params
+     *  @throws std::runtime_error
+     */
+    Generator(const Params &params) : _params(params)
+    {
+        // check the parameters
+        if (_params.symbols == 0 || _params.symbols > UINT32_MAX || _params.exchanges == 0 || _params.exchanges > 255 || _params.duration == 0 || _params.tick == 0 || _params.decimals > 9 || _params.price <= 0.0) throw std::runtime_error("invalid generator parameters");
+
+        // seed the random numbers with splitmix64
+        uint64_t seed = _params.seed;
+        for (auto &state : _state)
+        {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            state = z ^ (z >> 31);
+        }
+
+        // the part of the events in bursts, they take less time
+        double burst = _params.bursts * _params.length / (1.0 + _params.bursts * _params.length);
+        double time = (1.0 - burst) + burst / std::max(_params.intensity, 1.0);
+
+        // the rate that makes the events fill the day
+        _rate = std::max<size_t>(_params.events, 1) * time / (_params.duration * 1000.0);
+
+        // the units in a whole price
+        for (unsigned i = 0; i < _params.decimals; i++) _scale *= 10;
+
+        // the first price in units, on a tick
+        int64_t units = std::llround(_params.price * std::pow(10.0, _params.decimals));
+        units -= units % _params.tick;
+
+        // the variance of a day in ticks, spread over the events of a symbol
+        double ticks = _params.volatility * units / _params.tick;
+        double variance = ticks * ticks / std::max<double>(1.0, double(_params.events) / _params.symbols);
+
+        // moves of a single tick if that is enough, otherwise larger ones
+        _step = std::max<int64_t>(1, std::ceil(std::sqrt(variance)));
+        _move = variance / (_step * _step);
+
+        // all symbols start at the same price
+        for (size_t i = 0; i < _params.symbols; i++)
+        {
+            _symbols.push_back(Symbol{ units, 1 + int64_t(geometric(_params.spread - 1)) });
+            _names.push_back(_params.symbols == 1 ? "TEST" : "SYM" + std::to_string(i));
+        }
+    }
+
+    /**
+     *  Generate the next event
+     *  @param  event
+     *  @return bool    false when all events were generated
+     */
+    bool next(Event &event)
+    {
+        // are we done?
+        if (_count >= _params.events) return false;
+        event.sequence = ++_count;
+
+        // a burst may start, or end
+        if (_burst > 0) _burst--;
+        else if (uniform() <= _params.bursts) _burst = 1 + geometric(_params.length);
+
+        // the time of the event
+        _clock -= std::log(uniform()) / (_burst > 0 ? _rate * std::max(_params.intensity, 1.0) : _rate);
+        event.time = (_params.start * 1000 + uint64_t(_clock));
+
+        // the symbol and the exchange
+        event.symbol = _params.symbols == 1 ? 0 : below(_params.symbols);
+        event.exchange = _params.exchanges == 1 ? 1 : 1 + below(_params.exchanges);
+        event.condition = 0;
+        Symbol &symbol = _symbols[event.symbol];
+
+        // the price may move, and the spread may change
+        uint64_t draw = random();
+        if ((draw >> 11) * (1.0 / 9007199254740992.0) < _move) symbol.bid = std::max<int64_t>(_params.tick, symbol.bid + ((draw & 1) ? _step : -_step) * _params.tick);
+        if ((draw & 0x3e) == 0) symbol.spread = 1 + geometric(_params.spread - 1);
+        int64_t ask = symbol.bid + symbol.spread * _params.tick;
+
+        // the market opens with an ask and a bid
+        if (symbol.opening > 0)
+        {
+            event.type = symbol.opening-- == 2 ? 3 : 2;
+            event.price = event.type == 2 ? symbol.bid : ask;
+            event.size = _params.lot * (1 + halving());
+            return true;
+        }
+
+        // a trade, at the bid or the ask
+        if (uniform() <= _params.trades)
+        {
+            event.type = 1;
+            event.price = (draw & 0x40) ? ask : symbol.bid;
+            event.size = uniform() <= _params.odd ? 1 + below(std::max<size_t>(_params.lot - 1, 1)) : _params.lot * (1 + halving());
+            if (_params.conditions > 0.0 && uniform() <= _params.conditions) event.condition = 12;
+            return true;
+        }
+
+        // a quote, on either side
+        event.type = (draw & 0x80) ? 3 : 2;
+        event.price = event.type == 2 ? symbol.bid : ask;
+        event.size = _params.lot * (1 + halving());
+        return true;
+    }
+
+    /**
+     *  Append an event as a line
+     *  @param  output
+     *  @param  event
+     *  @param  format
+     *  @throws std::runtime_error  if a tape would get more than one symbol
+     */
+    void append(std::string &output, const Event &event, TapeIndex::Format format) const
+    {
+        // the line is written in place, the symbols are short
+        char line[192];
+        char *position = line;
+
+        // the type
+        *position++ = '0' + event.type;
+        *position++ = ',';
+
+        // a tape only has the time in milliseconds, the price and the size
+        if (format == TapeIndex::Tape)
+        {
+            if (event.symbol != 0) throw std::runtime_error("a tape can only have a single symbol");
+            position = digits(position, event.time / 1000);
+            *position++ = ',';
+            position = price(position, event.price);
+            *position++ = ',';
+            position = digits(position, event.size);
+            *position++ = '\n';
+            output.append(line, position - line);
+            return;
+        }
+
+        // the symbol, the exchange, the sequence and the flags
+        const std::string &name = _names[event.symbol];
+        memcpy(position, name.data(), name.size());
+        position += name.size();
+        *position++ = ',';
+        position = digits(position, event.exchange);
+        *position++ = ',';
+        position = digits(position, event.sequence);
+        memcpy(position, ",0,", 3);
+        position += 3;
+
+        // the time of day, with microseconds
+        uint64_t seconds = event.time / 1000000;
+        position = digits(position, seconds / 3600 % 24, 2);
+        *position++ = ':';
+        position = digits(position, seconds / 60 % 60, 2);
+        *position++ = ':';
+        position = digits(position, seconds % 60, 2);
+        *position++ = '.';
+        position = digits(position, event.time % 1000000, 6);
+
+        // the price, the size and the condition
+        *position++ = ',';
+        position = price(position, event.price);
+        *position++ = ',';
+        position = digits(position, event.size);
+        *position++ = ',';
+        position = digits(position, event.condition);
+        *position++ = '\n';
+        output.append(line, position - line);
+    }
+
+    /**
+     *  The header of a format
+     *  @param  format
+     *  @return const char*
+     */
+    static const char *header(TapeIndex::Format format)
+    {
+        // the columns
+        return format == TapeIndex::Tape ? "event,time,price,size\n" : "type,symbol,exchange,sequence,flags,time,price,size,condition\n";
+    }
+
+    /**
+     *  Generate all (remaining) events into a string
+     *  @param  format
+     *  @return std::string
+     *  @throws std::runtime_error
+     */
+    std::string text(TapeIndex::Format format)
+    {
+        // the header, and all events
+        std::string output = header(format);
+        output.reserve((_params.events - _count) * (format == TapeIndex::Tape ? 24 : 56));
+        Event event;
+        while (next(event)) append(output, event, format);
+        return output;
+    }
+
+    /**
+     *  Generate all (remaining) events into a file
+     *  @param  path
+     *  @param  format
+     *  @return size_t  number of events
+     *  @throws std::runtime_error
+     */
+    size_t write(const std::string &path, TapeIndex::Format format)
+    {
+        // open the file
+        FILE *file = fopen(path.c_str(), "w");
+        if (file == nullptr) throw std::runtime_error("failed to open output file: " + path + ": " + std::string(strerror(errno)));
+
+        // the events are collected in a buffer, that is written when it is full
+        std::string buffer = header(format);
+        buffer.reserve(1 << 21);
+        size_t events = 0;
+        Event event;
+        bool success = true;
+        try
+        {
+            // all events
+            while (success && next(event))
+            {
+                append(buffer, event, format);
+                events++;
+                if (buffer.size() < (1 << 20)) continue;
+                success = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+                buffer.clear();
+            }
+        }
+        catch (...) { fclose(file); throw; }
+
+        // the rest
+        success = success && fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        if (fclose(file) != 0 || !success) throw std::runtime_error("failed to write output file: " + path);
+        return events;
+    }
+
+    /**
+     *  Pass all (remaining) events of the first symbol to a processor,
+     *  without going through text
+     *  @param  processor
+     *  @return size_t  number of events
+     */
+    size_t run(EventProcessor &processor)
+    {
+        // the prices are passed on as they would be parsed
+        double scale = std::pow(10.0, -double(_params.decimals));
+
+        // all events
+        size_t events = 0;
+        Event event;
+        while (next(event))
+        {
+            // only of the first symbol
+            if (event.symbol != 0) continue;
+            Util::dispatch(processor, event.type, Quote(event.time / 1000, float(event.price * scale), event.size, event.exchange), "");
+            events++;
+        }
+        return events;
+    }
+
+    /**
+     *  Number of events generated so far
+     *  @return size_t
+     */
+    size_t count() const { return _count; }
+
+    /**
+     *  The name of a symbol
+     *  @param  index
+     *  @return std::string
+     */
+    const std::string &name(size_t index) const { return _names[index]; }
+};
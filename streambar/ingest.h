@@ -0,0 +1,609 @@
+/**
+ *  Ingest.h
+ *
+ *  Server that ingests events over a socket (a Unix domain socket, or TCP
+ *  on the loopback interface), and makes bars of them per symbol. Clients
+ *  send fixed size binary messages instead of text lines, so nothing has
+ *  to be parsed. The completed bars are published to the clients that
+ *  subscribed to their symbol, as fixed layout bar records.
+ *
+ *  All connections are handled by a single thread with poll, the events of
+ *  a connection are processed in the order they were sent, so a client can
+ *  subscribe and publish over the same connection. A subscriber that does
+ *  not keep up with its bars is disconnected, instead of slowing down the
+ *  ingestion.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "quote.h"
+#include "barmaker.h"
+#include "barspec.h"
+#include "barrecord.h"
+#include "accumulator.h"
+#include "symboltable.h"
+#include "util.h"
+
+class Ingest
+{
+public:
+    /**
+     *  The message that clients send, in the byte order of the machine and
+     *  without padding, the format is "<BBHIQd8s" (on little endian)
+     */
+    struct Message
+    {
+        /**
+         *  The type: 1 trade, 2 bid, 3 ask, 4 heartbeat, or one of the
+         *  commands below
+         */
+        uint8_t type;
+
+        /**
+         *  The exchange of the quote
+         */
+        uint8_t exchange;
+
+        /**
+         *  Unused
+         */
+        uint16_t reserved;
+
+        /**
+         *  The size, the time and the price of the quote
+         */
+        uint32_t size;
+        uint64_t time;
+        double price;
+
+        /**
+         *  The symbol, padded with zeroes (empty for all symbols in a command)
+         */
+        char symbol[8];
+    };
+
+    /**
+     *  The commands, subscribe to the bars of a symbol (or all of them), and
+     *  complete the open bar of a symbol (or all of them)
+     */
+    static constexpr uint8_t Subscribe = 5;
+    static constexpr uint8_t Flush = 6;
+
+    /**
+     *  Subscribers that have this many bytes waiting are disconnected
+     */
+    static constexpr size_t backlog = 64 * 1024 * 1024;
+
+private:
+    /**
+     *  A client
+     */
+    struct Connection
+    {
+        /**
+         *  The socket
+         */
+        int fd;
+
+        /**
+         *  Bytes that were received but are not a complete message yet, and
+         *  bytes that still have to be sent
+         */
+        std::string input;
+        std::string output;
+
+        /**
+         *  The subscriptions, to all symbols or by the index of the symbol
+         */
+        bool all = false;
+        std::vector<bool> symbols;
+    };
+
+    /**
+     *  The bars of a symbol
+     */
+    class Symbol : public Bar::Handler
+    {
+    private:
+        /**
+         *  The server to publish to, and the index of the symbol
+         */
+        Ingest *_server;
+        size_t _index;
+
+        /**
+         *  The processor, and the maker that uses it
+         */
+        std::unique_ptr<Processor> _processor;
+        BarMaker _maker;
+
+    public:
+        /**
+         *  Constructor
+         *  @param  server
+         *  @param  index
+         *  @param  spec
+         */
+        Symbol(Ingest *server, size_t index, const BarSpec &spec) :
+            _server(server), _index(index), _processor(spec.create()), _maker(this, _processor.get()) {}
+
+        /**
+         *  The maker
+         *  @return BarMaker
+         */
+        BarMaker &maker() { return _maker; }
+
+        /**
+         *  Called when a bar is done
+         *  @param  bar
+         */
+        virtual void onBar(const std::shared_ptr<Bar> &bar) override
+        {
+            // bars without trades are not published
+            if (!bar || bar->size() == 0) return;
+
+            // publish its statistics
+            _server->publish(_index, Accumulator(*bar));
+        }
+    };
+
+    /**
+     *  Number of chunks read from a client before the others get their turn
+     */
+    static constexpr size_t chunks = 16;
+
+    /**
+     *  The bar that is made for every symbol
+     */
+    BarSpec _spec;
+
+    /**
+     *  The listening socket, and the pipe to wake up the loop
+     */
+    int _listen = -1;
+    int _wakeup[2] = { -1, -1 };
+
+    /**
+     *  The symbols, with their bars by index
+     */
+    SymbolTable _symbols;
+    std::vector<std::unique_ptr<Symbol>> _makers;
+
+    /**
+     *  The clients
+     */
+    std::vector<Connection> _connections;
+
+    /**
+     *  Whether the loop should stop
+     */
+    std::atomic<bool> _stopped{false};
+
+    /**
+     *  Counters, they may be read from another thread
+     */
+    std::atomic<size_t> _events{0};
+    std::atomic<size_t> _bars{0};
+    std::atomic<size_t> _clients{0};
+    std::atomic<size_t> _symbolcount{0};
+
+    /**
+     *  Create the pipe to wake up the loop
+     *  @throws std::runtime_error
+     */
+    void prepare()
+    {
+        // the pipe does not block, the loop drains it
+        if (pipe2(_wakeup, O_NONBLOCK | O_CLOEXEC) != 0) throw std::runtime_error("failed to create pipe: " + std::string(strerror(errno)));
+    }
+
+    /**
+     *  Start listening on the socket that was bound
+     *  @param  address     for the error
+     *  @throws std::runtime_error
+     */
+    void listen(const std::string &address)
+    {
+        // allow connections
+        if (::listen(_listen, 128) == 0) return;
+
+        // keep the error, the destructor does not run
+        std::string error = strerror(errno);
+        close(_listen);
+        close(_wakeup[0]);
+        close(_wakeup[1]);
+        throw std::runtime_error("failed to listen on " + address + ": " + error);
+    }
+
+    /**
+     *  Close the sockets and the pipe, after a failed bind
+     *  @param  address
+     *  @throws std::runtime_error
+     */
+    [[noreturn]] void fail(const std::string &address)
+    {
+        // keep the error, the destructor does not run
+        std::string error = strerror(errno);
+        close(_listen);
+        close(_wakeup[0]);
+        close(_wakeup[1]);
+        throw std::runtime_error("failed to bind to " + address + ": " + error);
+    }
+
+    /**
+     *  The index of a symbol, its bars are created on first sight
+     *  @param  symbol
+     *  @param  size
+     *  @return size_t
+     */
+    size_t index(const char *symbol, size_t size)
+    {
+        // find the symbol
+        size_t index = _symbols.find(symbol, size);
+        if (index != SymbolTable::npos) return index;
+
+        // add it, with its bars
+        index = _symbols.insert(symbol, size);
+        _makers.emplace_back(new Symbol(this, index, _spec));
+        _symbolcount++;
+        return index;
+    }
+
+    /**
+     *  Accept the new clients
+     */
+    void accept()
+    {
+        // accept all that are waiting
+        while (true)
+        {
+            // the socket does not block
+            int fd = accept4(_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+
+            // bars should go out at once, on tcp (fails harmlessly on unix sockets)
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+            // add the client
+            _connections.emplace_back();
+            _connections.back().fd = fd;
+            _clients++;
+        }
+    }
+
+    /**
+     *  Handle a message of a client
+     *  @param  connection
+     *  @param  message
+     *  @return bool        false if the message is not valid
+     */
+    bool handle(Connection &connection, const Message &message)
+    {
+        // the symbol, it is not terminated if it is the full length
+        size_t size = strnlen(message.symbol, sizeof(message.symbol));
+
+        // check the type
+        switch (message.type) {
+        case 1: case 2: case 3: case 4:
+            // an event, for the bars of the symbol
+            Util::dispatch(_makers[index(message.symbol, size)]->maker(), message.type, Quote(message.time, message.price, message.size, message.exchange), "");
+            _events++;
+            return true;
+
+        case Subscribe:
+            // to all the symbols
+            if (size == 0) { connection.all = true; return true; }
+
+            // to a single symbol
+            {
+                size_t symbol = index(message.symbol, size);
+                if (connection.symbols.size() <= symbol) connection.symbols.resize(symbol + 1);
+                connection.symbols[symbol] = true;
+            }
+            return true;
+
+        case Flush:
+            // complete the open bars of all the symbols, or of one
+            if (size == 0) for (auto &symbol : _makers) symbol->maker().flush();
+            else _makers[index(message.symbol, size)]->maker().flush();
+            return true;
+
+        default:
+            // not a valid message, the client is not speaking our protocol
+            return false;
+        }
+    }
+
+    /**
+     *  Handle the complete messages that a client sent
+     *  @param  connection
+     *  @return bool        false if the client should be disconnected
+     */
+    bool consume(Connection &connection)
+    {
+        // handle all the complete messages
+        size_t offset = 0;
+        for (; offset + sizeof(Message) <= connection.input.size(); offset += sizeof(Message))
+        {
+            // copy the message, the buffer may not be aligned
+            Message message;
+            memcpy(&message, connection.input.data() + offset, sizeof(Message));
+            if (!handle(connection, message)) return false;
+        }
+
+        // keep the partial message
+        connection.input.erase(0, offset);
+        return true;
+    }
+
+    /**
+     *  Read and handle what a client sent, at most a number of chunks, so
+     *  that a fast client does not starve the others (poll tells us again
+     *  that there is more)
+     *  @param  connection
+     *  @return bool        false if the client should be disconnected
+     */
+    bool receive(Connection &connection)
+    {
+        // read until there is nothing more, or we had enough of this client
+        char chunk[65536];
+        for (size_t count = 0; count < chunks; count++)
+        {
+            // read a chunk
+            ssize_t size = read(connection.fd, chunk, sizeof(chunk));
+            if (size < 0 && errno == EINTR) continue;
+            if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            if (size <= 0) return false;
+
+            // add it, and handle the messages in it at once, so the buffer stays small
+            connection.input.append(chunk, size);
+            if (!consume(connection)) return false;
+        }
+
+        // the rest is for the next time
+        return true;
+    }
+
+    /**
+     *  Send what is waiting for a client
+     *  @param  connection
+     *  @return bool        false if the client should be disconnected
+     */
+    bool send(Connection &connection)
+    {
+        // a subscriber that does not keep up is dropped
+        if (connection.output.size() > backlog) return false;
+
+        // send as much as the socket takes
+        size_t offset = 0;
+        while (offset < connection.output.size())
+        {
+            // send a part
+            ssize_t size = ::send(connection.fd, connection.output.data() + offset, connection.output.size() - offset, MSG_NOSIGNAL);
+            if (size < 0 && errno == EINTR) continue;
+            if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (size < 0) return false;
+            offset += size;
+        }
+
+        // keep the rest
+        connection.output.erase(0, offset);
+        return true;
+    }
+
+    /**
+     *  Publish a bar to the subscribers of its symbol
+     *  @param  index
+     *  @param  bar
+     */
+    void publish(size_t index, const Accumulator &bar)
+    {
+        // the record of the bar
+        BarRecord record = BarRecord::make(_symbols.name(index), bar);
+        _bars++;
+
+        // add it for the subscribers, it is sent after the messages are handled
+        for (auto &connection : _connections)
+        {
+            // only if it subscribed to the symbol
+            if (!connection.all && (index >= connection.symbols.size() || !connection.symbols[index])) continue;
+            connection.output.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+    }
+
+public:
+    /**
+     *  Constructor, listens on a Unix domain socket, an existing socket file
+     *  is replaced (but any other file is left alone)
+     *  @param  spec    the bar to make for every symbol
+     *  @param  path    the socket file
+     *  @throws std::runtime_error
+     */
+    Ingest(const BarSpec &spec, const std::string &path) : _spec(spec)
+    {
+        // the address must fit
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("socket path is too long: " + path);
+        memcpy(address.sun_path, path.data(), path.size());
+
+        // only the socket file of a previous run may be replaced
+        struct stat info;
+        if (lstat(path.c_str(), &info) == 0 && !S_ISSOCK(info.st_mode)) throw std::runtime_error("failed to bind to " + path + ": file exists and is not a socket");
+
+        // create the socket
+        prepare();
+        _listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+        // replace the socket file of a previous run
+        unlink(path.c_str());
+        if (_listen < 0 || bind(_listen, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) fail(path);
+
+        // and listen on it
+        listen(path);
+    }
+
+    /**
+     *  Constructor, listens on TCP on the loopback interface
+     *  @param  spec    the bar to make for every symbol
+     *  @param  port    the port, 0 to pick a free one
+     *  @throws std::runtime_error
+     */
+    Ingest(const BarSpec &spec, uint16_t port) : _spec(spec)
+    {
+        // only on the loopback interface
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        // create the socket, a port of a previous run may be reused at once
+        prepare();
+        _listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int yes = 1;
+        if (_listen >= 0) setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (_listen < 0 || bind(_listen, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) fail("port " + std::to_string(port));
+
+        // and listen on it
+        listen("port " + std::to_string(port));
+    }
+
+    /**
+     *  No copying
+     */
+    Ingest(const Ingest &that) = delete;
+
+    /**
+     *  Destructor
+     */
+    virtual ~Ingest()
+    {
+        // disconnect the clients, the open bars have nobody to go to
+        for (auto &connection : _connections) close(connection.fd);
+        _connections.clear();
+        _makers.clear();
+
+        // close the socket and the pipe
+        close(_listen);
+        close(_wakeup[0]);
+        close(_wakeup[1]);
+    }
+
+    /**
+     *  Wait for the sockets once, and handle what happened
+     *  @param  timeout     milliseconds, -1 to wait forever
+     *  @throws std::runtime_error
+     */
+    void step(int timeout)
+    {
+        // the pipe, the listening socket, and the clients (also if we have something to send)
+        std::vector<struct pollfd> fds;
+        fds.push_back({ _wakeup[0], POLLIN, 0 });
+        fds.push_back({ _listen, POLLIN, 0 });
+        for (auto &connection : _connections) fds.push_back({ connection.fd, short(connection.output.empty() ? POLLIN : POLLIN | POLLOUT), 0 });
+
+        // wait for something to happen
+        int result = ::poll(fds.data(), fds.size(), timeout);
+        if (result < 0 && errno == EINTR) return;
+        if (result < 0) throw std::runtime_error("failed to poll: " + std::string(strerror(errno)));
+        if (result == 0) return;
+
+        // drain the pipe, we only need to know that we were woken up
+        char drain[64];
+        while (read(_wakeup[0], drain, sizeof(drain)) > 0) {}
+
+        // the clients that are disconnected
+        std::vector<bool> closed(_connections.size(), false);
+
+        // handle what the clients sent, before the new ones are added
+        for (size_t i = 0; i < closed.size(); i++)
+        {
+            // only if there is something
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) closed[i] = !receive(_connections[i]);
+        }
+
+        // accept the new clients
+        if (fds[1].revents & POLLIN) accept();
+        closed.resize(_connections.size(), false);
+
+        // send the bars that were completed, and remove the clients that are gone
+        size_t kept = 0;
+        for (size_t i = 0; i < _connections.size(); i++)
+        {
+            // close the clients that are gone, or that do not keep up
+            if (closed[i] || !send(_connections[i])) { close(_connections[i].fd); _clients--; continue; }
+
+            // keep it
+            if (kept != i) _connections[kept] = std::move(_connections[i]);
+            kept++;
+        }
+        _connections.resize(kept);
+    }
+
+    /**
+     *  Handle the clients until stop is called
+     *  @throws std::runtime_error
+     */
+    void run()
+    {
+        // until we are stopped
+        while (!_stopped) step(-1);
+    }
+
+    /**
+     *  Stop the loop, may be called from another thread
+     */
+    void stop()
+    {
+        // mark it, and wake up the loop
+        _stopped = true;
+        if (write(_wakeup[1], "x", 1) < 0) {}
+    }
+
+    /**
+     *  The port we listen on, for TCP
+     *  @return uint16_t    0 on a Unix domain socket
+     */
+    uint16_t port() const
+    {
+        // look up the address
+        struct sockaddr_in address;
+        socklen_t size = sizeof(address);
+        if (getsockname(_listen, reinterpret_cast<struct sockaddr*>(&address), &size) != 0 || address.sin_family != AF_INET) return 0;
+        return ntohs(address.sin_port);
+    }
+
+    /**
+     *  Number of events processed, bars published and clients connected
+     *  @return size_t
+     */
+    size_t events() const { return _events; }
+    size_t bars() const { return _bars; }
+    size_t clients() const { return _clients; }
+
+    /**
+     *  Number of symbols, it may be read from another thread too
+     *  @return size_t
+     */
+    size_t symbols() const { return _symbolcount; }
+};
@@ -0,0 +1,374 @@
+/**
+ *  Instrument.h
+ *
+ *  Optional instrumentation of where the time goes: latency histograms of
+ *  the stages (parsing a line, filtering it, checking whether a trade fits
+ *  the bar, adding it, and handling a completed bar), and the number of
+ *  events per second of the runs. It is only compiled in when
+ *  STREAMBAR_INSTRUMENT is defined, otherwise the probes are empty and
+ *  cost nothing.
+ *
+ *  The stages are timed with the time stamp counter, and converted to
+ *  nanoseconds when they are reported. The histograms have a bucket per
+ *  eighth of every power of two, so a percentile is within 12.5 percent.
+ *  Every thread records into its own instrumentation, which is added to
+ *  the shared totals when the thread ends.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <array>
+#include <utility>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class Histogram
+{
+public:
+    /**
+     *  Values below this are counted exactly, above it per eighth of a power of two
+     */
+    static constexpr size_t exact = 16;
+    static constexpr size_t buckets = exact + (64 - 4) * 8;
+
+private:
+    /**
+     *  The counts per bucket
+     */
+    std::array<uint64_t, buckets> _counts{};
+
+    /**
+     *  Number of values, their sum, and the lowest and highest
+     */
+    uint64_t _count = 0;
+    uint64_t _total = 0;
+    uint64_t _min = UINT64_MAX;
+    uint64_t _max = 0;
+
+    /**
+     *  The bucket of a value
+     *  @param  value
+     *  @return size_t
+     */
+    static size_t bucket(uint64_t value)
+    {
+        // the small values are exact
+        if (value < exact) return value;
+
+        // the power of two, and the eighth within it
+        size_t power = 63 - __builtin_clzll(value);
+        return exact + (power - 4) * 8 + ((value >> (power - 3)) & 7);
+    }
+
+    /**
+     *  The highest value in a bucket
+     *  @param  index
+     *  @return uint64_t
+     */
+    static uint64_t highest(size_t index)
+    {
+        // the small values are exact
+        if (index < exact) return index;
+
+        // the power of two, and the eighth within it
+        size_t power = (index - exact) / 8 + 4;
+        uint64_t lowest = (8 + (index - exact) % 8) << (power - 3);
+        return lowest + (uint64_t(1) << (power - 3)) - 1;
+    }
+
+public:
+    /**
+     *  Record a value
+     *  @param  value
+     */
+    void record(uint64_t value)
+    {
+        // count it
+        _counts[bucket(value)]++;
+        _count++;
+        _total += value;
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+    }
+
+    /**
+     *  Add the values of another histogram
+     *  @param  that
+     */
+    void merge(const Histogram &that)
+    {
+        // all the buckets, and the totals
+        for (size_t i = 0; i < buckets; i++) _counts[i] += that._counts[i];
+        _count += that._count;
+        _total += that._total;
+        _min = std::min(_min, that._min);
+        _max = std::max(_max, that._max);
+    }
+
+    /**
+     *  The value below which a fraction of the values are
+     *  @param  fraction    between 0 and 1
+     *  @return uint64_t    the highest value of its bucket, but not above the maximum
+     */
+    uint64_t percentile(double fraction) const
+    {
+        // without values there is nothing
+        if (_count == 0) return 0;
+
+        // the number of values to pass
+        uint64_t rank = std::max<uint64_t>(1, std::min<uint64_t>(_count, fraction * _count + 0.5));
+
+        // find the bucket it is in
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets; i++) if ((seen += _counts[i]) >= rank) return std::min(highest(i), _max);
+
+        // not reached
+        return _max;
+    }
+
+    /**
+     *  Number of values, and their sum
+     *  @return uint64_t
+     */
+    uint64_t count() const { return _count; }
+    uint64_t total() const { return _total; }
+
+    /**
+     *  The lowest and highest value
+     *  @return uint64_t
+     */
+    uint64_t min() const { return _count == 0 ? 0 : _min; }
+    uint64_t max() const { return _max; }
+};
+
+class Instrumentation
+{
+public:
+    /**
+     *  The stages, the parsing includes the filtering
+     */
+    enum Stage { Parse, Filter, Fits, Add, Bar, Stages };
+
+    /**
+     *  Whether the instrumentation is compiled in
+     */
+#ifdef STREAMBAR_INSTRUMENT
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    /**
+     *  The histograms of the stages, in ticks
+     */
+    std::array<Histogram, Stages> stages;
+
+    /**
+     *  Number of events, and the seconds the runs took
+     */
+    uint64_t events = 0;
+    double seconds = 0.0;
+
+    /**
+     *  The name of a stage
+     *  @param  stage
+     *  @return const char*
+     */
+    static const char *name(size_t stage)
+    {
+        // the names, in the order of the stages
+        static const char *names[] = { "parse", "filter", "fits", "add", "bar" };
+        return names[stage];
+    }
+
+    /**
+     *  The current tick
+     *  @return uint64_t
+     */
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        // the time stamp counter
+        return __rdtsc();
+#else
+        // nanoseconds elsewhere
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /**
+     *  The tick and the time when the instrumentation was first used
+     *  @return std::pair
+     */
+    static const std::pair<uint64_t, std::chrono::steady_clock::time_point> &origin()
+    {
+        // taken once
+        static const std::pair<uint64_t, std::chrono::steady_clock::time_point> origin(now(), std::chrono::steady_clock::now());
+        return origin;
+    }
+
+    /**
+     *  Number of ticks in a nanosecond, measured since the first use
+     *  @return double
+     */
+    static double ticksPerNanosecond()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        // compare how far the counter and the clock went, over at least a millisecond
+        const auto &start = origin();
+        while (std::chrono::steady_clock::now() - start.second < std::chrono::milliseconds(1)) {}
+        uint64_t ticks = now() - start.first;
+        auto elapsed = std::chrono::steady_clock::now() - start.second;
+        return double(ticks) / std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+#else
+        // the ticks are nanoseconds
+        return 1.0;
+#endif
+    }
+
+    /**
+     *  Add another instrumentation
+     *  @param  that
+     */
+    void merge(const Instrumentation &that)
+    {
+        // all the stages, and the counters
+        for (size_t i = 0; i < Stages; i++) stages[i].merge(that.stages[i]);
+        events += that.events;
+        seconds += that.seconds;
+    }
+
+    /**
+     *  Events per second of the runs
+     *  @return double
+     */
+    double rate() const { return seconds > 0.0 ? events / seconds : 0.0; }
+
+    /**
+     *  The instrumentation of the threads that ended, and a lock for it
+     *  @return Instrumentation
+     */
+    static Instrumentation &shared() { static Instrumentation instrumentation; return instrumentation; }
+    static std::mutex &mutex() { static std::mutex mutex; return mutex; }
+
+    /**
+     *  The instrumentation of this thread
+     *  @return Instrumentation
+     */
+    static Instrumentation &current()
+    {
+        // added to the shared one when the thread ends
+        struct Local
+        {
+            Instrumentation instrumentation;
+            Local() { origin(); }
+            ~Local() { std::lock_guard<std::mutex> lock(mutex()); shared().merge(instrumentation); }
+        };
+
+        // one per thread
+        static thread_local Local local;
+        return local.instrumentation;
+    }
+
+    /**
+     *  The shared instrumentation together with that of this thread
+     *  @return Instrumentation
+     */
+    static Instrumentation total()
+    {
+        // copy the shared one, and add ours
+        std::lock_guard<std::mutex> lock(mutex());
+        Instrumentation result = shared();
+        result.merge(current());
+        return result;
+    }
+
+    /**
+     *  Forget what was recorded, by the threads that ended and by this one
+     */
+    static void clear()
+    {
+        // both start over
+        std::lock_guard<std::mutex> lock(mutex());
+        shared() = Instrumentation();
+        current() = Instrumentation();
+    }
+
+    /**
+     *  Count an event
+     */
+    static void count()
+    {
+#ifdef STREAMBAR_INSTRUMENT
+        current().events++;
+#endif
+    }
+
+    /**
+     *  Times a stage, from construction to destruction
+     */
+    class Probe
+    {
+#ifdef STREAMBAR_INSTRUMENT
+    private:
+        /**
+         *  The stage, and when it started
+         */
+        Stage _stage;
+        uint64_t _start;
+
+    public:
+        /**
+         *  Constructor
+         *  @param  stage
+         */
+        Probe(Stage stage) : _stage(stage), _start(now()) {}
+
+        /**
+         *  Destructor, records the time
+         */
+        ~Probe() { current().stages[_stage].record(now() - _start); }
+#else
+    public:
+        /**
+         *  Constructor, does nothing
+         *  @param  stage
+         */
+        Probe(Stage stage) {}
+#endif
+    };
+
+    /**
+     *  Times a run, for the events per second
+     */
+    class Run
+    {
+#ifdef STREAMBAR_INSTRUMENT
+    private:
+        /**
+         *  When it started
+         */
+        std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+    public:
+        /**
+         *  Destructor, adds the time
+         */
+        ~Run() { current().seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+#else
+    public:
+        /**
+         *  Constructor and destructor, do nothing (but the run is not an unused variable)
+         */
+        Run() {}
+        ~Run() {}
+#endif
+    };
+};
@@ -0,0 +1,271 @@
+/**
+ *  Merge.h
+ *
+ *  Merges any number of tape (or MML) files into a single stream of events
+ *  in time order, for example when the trades and the quotes, or the
+ *  venues, come in separate files. Only the current event of every input
+ *  is kept in memory. The inputs compete in a loser tree, so finding the
+ *  next event costs log2(N) comparisons, and events with the same time are
+ *  passed on in the order in which the inputs were added.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include "quote.h"
+#include "eventprocessor.h"
+#include "filter.h"
+#include "tapeindex.h"
+#include "util.h"
+
+class Merge
+{
+private:
+    /**
+     *  A single input, with its current event
+     */
+    struct Input
+    {
+        /**
+         *  The stream, and the file if we opened it
+         */
+        std::unique_ptr<std::ifstream> file;
+        std::istream *stream;
+
+        /**
+         *  The current line, and the event on it
+         */
+        std::string line;
+        uint8_t type = 0;
+        Quote quote;
+
+        /**
+         *  Whether the input is exhausted
+         */
+        bool done = false;
+    };
+
+    /**
+     *  Format of the inputs
+     */
+    TapeIndex::Format _format;
+
+    /**
+     *  Filter for the mml records
+     */
+    Filter _filter;
+
+    /**
+     *  The inputs
+     */
+    std::vector<Input> _inputs;
+
+    /**
+     *  The loser tree, node 0 holds the winner, the other nodes the loser of
+     *  their match. The children of node n are 2n and 2n+1, and the nodes
+     *  from the number of inputs are the inputs themselves.
+     */
+    std::vector<size_t> _tree;
+
+    /**
+     *  Number of events passed on
+     */
+    size_t _events = 0;
+
+    /**
+     *  Move an input to its next event
+     *  @param  input
+     */
+    void advance(Input &input)
+    {
+        // keep reading until we find an event
+        while (std::getline(*input.stream, input.line))
+        {
+            // safety for empty lines
+            if (input.line.empty()) continue;
+
+            // parse in the right format, mml records may be filtered out
+            input.type = _format == TapeIndex::Tape ? Util::parseTape(input.line.c_str(), input.quote) : Util::parse(input.line.c_str(), input.quote, _filter);
+            if (input.type != 0) return;
+        }
+
+        // nothing left
+        input.done = true;
+    }
+
+    /**
+     *  Whether input a goes before input b, exhausted inputs go last, and
+     *  on equal times the input that was added first goes first
+     *  @param  a
+     *  @param  b
+     *  @return bool
+     */
+    bool before(size_t a, size_t b) const
+    {
+        // the inputs
+        const Input &x = _inputs[a];
+        const Input &y = _inputs[b];
+
+        // exhausted inputs lose
+        if (x.done != y.done) return y.done;
+
+        // the earliest time wins, then the source order
+        if (x.quote.time() != y.quote.time()) return x.quote.time() < y.quote.time();
+        return a < b;
+    }
+
+    /**
+     *  Play all matches, to build the tree
+     */
+    void build()
+    {
+        // number of inputs
+        size_t count = _inputs.size();
+        _tree.assign(count, 0);
+
+        // the winners of every node, the inputs are at the leaves
+        std::vector<size_t> winners(count * 2);
+        for (size_t i = 0; i < count; i++) winners[count + i] = i;
+
+        // play the matches from the bottom up, the loser stays in the node
+        for (size_t node = count - 1; node > 0; node--)
+        {
+            // the two contenders
+            size_t left = winners[node * 2];
+            size_t right = winners[node * 2 + 1];
+
+            // the winner goes up
+            winners[node] = before(right, left) ? right : left;
+            _tree[node] = before(right, left) ? left : right;
+        }
+
+        // the overall winner
+        _tree[0] = count == 1 ? 0 : winners[1];
+    }
+
+    /**
+     *  Replay the matches of an input after it moved to its next event
+     *  @param  input
+     */
+    void replay(size_t input)
+    {
+        // from the leaf up to the top, the winner of every match moves on
+        for (size_t node = (_inputs.size() + input) / 2; node > 0; node /= 2)
+        {
+            // if the loser in the node beats us, it moves on instead
+            if (before(_tree[node], input)) std::swap(_tree[node], input);
+        }
+
+        // the overall winner
+        _tree[0] = input;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  format  format of all the inputs
+     *  @param  filter  filter for the mml records
+     */
+    Merge(TapeIndex::Format format = TapeIndex::Tape, Filter filter = Filter()) : _format(format), _filter(std::move(filter)) {}
+
+    /**
+     *  No copying
+     */
+    Merge(const Merge &that) = delete;
+
+    /**
+     *  Add an input stream, it is not owned, must be done before processing
+     *  @param  stream
+     */
+    void add(std::istream &stream)
+    {
+        // add the input
+        _inputs.emplace_back();
+        _inputs.back().stream = &stream;
+    }
+
+    /**
+     *  Add an input file, must be done before processing
+     *  @param  name
+     *  @throws std::runtime_error
+     */
+    void add(const std::string &name)
+    {
+        // open the file
+        std::unique_ptr<std::ifstream> file(new std::ifstream(name));
+        if (!file->good()) throw std::runtime_error("failed to open input file: " + name + ": " + std::string(strerror(errno)));
+
+        // add the input
+        add(*file);
+        _inputs.back().file = std::move(file);
+    }
+
+    /**
+     *  Process all inputs, in time order
+     *  @param  maker
+     *  @param  start   trades before this time are skipped
+     *  @param  end     processing stops after this time
+     */
+    void process(EventProcessor &maker, size_t start = 0, size_t end = SIZE_MAX)
+    {
+        // nothing to merge
+        if (_inputs.empty()) return;
+
+        // skip the headers, and read the first events
+        for (auto &input : _inputs)
+        {
+            Util::skipHeader(*input.stream);
+            advance(input);
+        }
+
+        // build the tree
+        build();
+
+        // keep taking the winner
+        while (true)
+        {
+            // the input with the earliest event
+            Input &input = _inputs[_tree[0]];
+
+            // if even that one is done, all are
+            if (input.done) return;
+
+            // stop after the end
+            if (input.quote.time() > end) return;
+
+            // skip the trades before the start, pass on the rest
+            if (input.type != 1 || input.quote.time() >= start) { Util::dispatch(maker, input.type, input.quote, input.line.c_str()); _events++; }
+
+            // move on to the next event of the input, and find the new winner
+            advance(input);
+            replay(_tree[0]);
+        }
+    }
+
+    /**
+     *  Number of inputs
+     *  @return size_t
+     */
+    size_t size() const { return _inputs.size(); }
+
+    /**
+     *  Number of events that were passed on
+     *  @return size_t
+     */
+    size_t events() const { return _events; }
+
+    /**
+     *  The filter, with the number of records it dropped
+     *  @return Filter
+     */
+    const Filter &filter() const { return _filter; }
+};
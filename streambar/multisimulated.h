@@ -0,0 +1,166 @@
+/**
+ *  MultiSimulated.h
+ *
+ *  Simulation of any number of strategies against a single pass over the
+ *  market data. The strategies are kept in a min-heap on the time of their
+ *  next action, so every quote only touches the strategies that are due.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "eventprocessor.h"
+#include "strategy.h"
+
+class MultiSimulated : public EventProcessor
+{
+private:
+    /**
+     *  All the strategies
+     */
+    std::vector<std::unique_ptr<Strategy>> _strategies;
+
+    /**
+     *  Min-heap of indices into the strategies, on the time of their next action
+     */
+    std::vector<size_t> _heap;
+
+    /**
+     *  Last bid/ask
+     */
+    Quote _ask;
+    Quote _bid;
+
+    /**
+     *  Ordering of the heap, the strategy with the earliest next action goes on top
+     *  @param  a
+     *  @param  b
+     *  @return bool
+     */
+    bool later(size_t a, size_t b) const { return _strategies[a]->next() > _strategies[b]->next(); }
+
+    /**
+     *  Helper method to process all actions before the given time, they
+     *  are executed against the bid/ask from before the update
+     *  @param  time
+     */
+    void process(size_t time)
+    {
+        // the comparison for the heap
+        auto compare = [this](size_t a, size_t b) { return later(a, b); };
+
+        // execute the actions of the strategies that are due
+        while (!_heap.empty() && time > _strategies[_heap.front()]->next())
+        {
+            // take the strategy from the top, it moves to the back
+            std::pop_heap(_heap.begin(), _heap.end(), compare);
+
+            // execute its action
+            _strategies[_heap.back()]->execute(_bid, _ask);
+
+            // put it back if there is more to do, otherwise it leaves the heap
+            if (_strategies[_heap.back()]->next() != std::numeric_limits<size_t>::max()) std::push_heap(_heap.begin(), _heap.end(), compare);
+            else _heap.pop_back();
+        }
+    }
+
+public:
+    /**
+     *  Constructor
+     */
+    MultiSimulated() = default;
+
+    /**
+     *  Add a strategy, must be called before the market data is processed
+     *  @param  input   the actions
+     *  @param  output  the records of the executed actions
+     *  @param  costs   the costs of trading
+     *  @return size_t  index of the strategy
+     */
+    size_t add(std::istream &input, std::ostream &output, const Costs &costs = Costs())
+    {
+        // create the strategy
+        _strategies.emplace_back(new Strategy(input, output, costs));
+
+        // the index of the strategy
+        size_t index = _strategies.size() - 1;
+
+        // it only goes in the heap if it has something to do
+        if (_strategies[index]->next() == std::numeric_limits<size_t>::max()) return index;
+
+        // add to the heap
+        _heap.push_back(index);
+        std::push_heap(_heap.begin(), _heap.end(), [this](size_t a, size_t b) { return later(a, b); });
+
+        // return the index
+        return index;
+    }
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override
+    {
+        // ignore for now, nothing to do here
+    }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override
+    {
+        // before updating, we may need to process some actions
+        process(bid.time());
+
+        // simply remember
+        _bid = bid;
+    }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override
+    {
+        // before update, we may need to process actions
+        process(ask.time());
+
+        // simply remember
+        _ask = ask;
+    }
+
+    /**
+     *  Execute the actions that are left after the market data, against the last bid/ask
+     */
+    void flush()
+    {
+        // execute everything
+        process(std::numeric_limits<size_t>::max());
+    }
+
+    /**
+     *  Number of strategies
+     *  @return size_t
+     */
+    size_t size() const { return _strategies.size(); }
+
+    /**
+     *  A strategy, with its account
+     *  @param  index
+     *  @return Strategy
+     */
+    const Strategy &strategy(size_t index) const { return *_strategies[index]; }
+
+    /**
+     *  Value of a strategy at the last bid/ask
+     *  @param  index
+     *  @return double
+     */
+    double value(size_t index) const { return _strategies[index]->value(_bid, _ask); }
+};
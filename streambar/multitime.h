@@ -0,0 +1,196 @@
+/**
+ *  MultiTime.h
+ *
+ *  Time bars of several resolutions from a single pass. Only the finest
+ *  resolution is made from the trades, every coarser bar is the merge of
+ *  the accumulated statistics of the finest bars in its box, so the cost
+ *  is close to that of a single time bar run. The coarser resolutions must
+ *  be multiples of the finest one, so that no fine bar crosses a boundary.
+ *  All statistics merge exactly, except the mean absolute deviation, which
+ *  is an upper bound for the coarser bars.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+#include "bar.h"
+#include "barmaker.h"
+#include "accumulator.h"
+#include "eventprocessor.h"
+#include "bars/timebar.h"
+
+class MultiTime : public EventProcessor, private Bar::Handler
+{
+private:
+    /**
+     *  A resolution, with its open bar
+     */
+    struct Level
+    {
+        /**
+         *  Length of the boxes, in milliseconds
+         */
+        size_t interval;
+
+        /**
+         *  Where the bars go (not owned)
+         */
+        Accumulator::Handler *handler;
+
+        /**
+         *  The open bar, and its box
+         */
+        Accumulator bar;
+        size_t box = 0;
+    };
+
+    /**
+     *  The resolutions, the finest first
+     */
+    std::vector<Level> _levels;
+
+    /**
+     *  The processor and the maker for the finest bars
+     */
+    TimeBarProcessor _processor;
+    BarMaker _maker;
+
+    /**
+     *  Check the resolutions
+     *  @param  seconds
+     *  @param  handlers
+     *  @return size_t  the finest resolution
+     *  @throws std::runtime_error
+     */
+    static size_t finest(const std::vector<size_t> &seconds, const std::vector<Accumulator::Handler*> &handlers)
+    {
+        // need at least one, and a handler for every one
+        if (seconds.empty() || seconds[0] == 0) throw std::runtime_error("expected at least one resolution");
+        if (seconds.size() != handlers.size()) throw std::runtime_error("expected a handler per resolution");
+
+        // the coarser ones must be multiples of the finest
+        for (size_t i = 1; i < seconds.size(); i++)
+        {
+            // check the order, and the multiple
+            if (seconds[i] <= seconds[i - 1] || seconds[i] % seconds[0] != 0) throw std::runtime_error("expected increasing resolutions, that are multiples of the first");
+        }
+
+        // the finest one
+        return seconds[0];
+    }
+
+    /**
+     *  Emit the open bar of a resolution
+     *  @param  level
+     */
+    void emit(Level &level)
+    {
+        // pass it on, and start a new one
+        level.handler->onBar(level.bar);
+        level.bar = Accumulator();
+    }
+
+    /**
+     *  Called when a bar of the finest resolution is done
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // if the bar is not valid, leap out
+        if (!bar || bar->size() == 0) return;
+
+        // the statistics of the bar, and the time it started
+        Accumulator fine(*bar);
+        size_t time = fine.first();
+
+        // the finest resolution is simply passed on
+        _levels[0].handler->onBar(fine);
+
+        // merge it into the coarser ones
+        for (size_t i = 1; i < _levels.size(); i++)
+        {
+            // the level, and the box of the bar in it
+            Level &level = _levels[i];
+            size_t box = time / level.interval;
+
+            // if the open bar is in another box, it is done
+            if (!level.bar.empty() && box != level.box) emit(level);
+
+            // merge it in
+            level.box = box;
+            level.bar.merge(fine);
+        }
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  seconds     the resolutions, increasing, multiples of the first
+     *  @param  handlers    where the bars of every resolution go
+     *  @throws std::runtime_error
+     */
+    MultiTime(const std::vector<size_t> &seconds, const std::vector<Accumulator::Handler*> &handlers) :
+        _processor(finest(seconds, handlers)), _maker(this, &_processor)
+    {
+        // add all the resolutions
+        for (size_t i = 0; i < seconds.size(); i++) _levels.push_back(Level{ seconds[i] * 1000, handlers[i], Accumulator(), 0 });
+    }
+
+    /**
+     *  No copying, the maker points to us
+     */
+    MultiTime(const MultiTime &that) = delete;
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override { _maker.onTrade(trade); }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override { _maker.onBid(bid); }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override { _maker.onAsk(ask); }
+
+    /**
+     *  Process the passing of time, closes the bars of which the box is over
+     *  @param  time
+     */
+    virtual void onTime(size_t time) override
+    {
+        // the finest bar first, it may still go into the coarser ones
+        _maker.onTime(time);
+
+        // then the coarser ones
+        for (size_t i = 1; i < _levels.size(); i++)
+        {
+            // the level
+            Level &level = _levels[i];
+
+            // emit if the box is over
+            if (!level.bar.empty() && time / level.interval != level.box) emit(level);
+        }
+    }
+
+    /**
+     *  Complete the open bars of all resolutions
+     */
+    void flush()
+    {
+        // the finest bar first
+        _maker.flush();
+
+        // and then the coarser ones
+        for (size_t i = 1; i < _levels.size(); i++) if (!_levels[i].bar.empty()) emit(_levels[i]);
+    }
+};
@@ -0,0 +1,224 @@
+/**
+ *  Nbbo.h
+ *
+ *  Consolidates the quotes of all exchanges into the national best bid and
+ *  offer, before passing them on to another event processor. The last bid
+ *  and ask of every exchange are kept in a fixed array, with a tournament
+ *  tree on top of it, so an update only replays the matches on the path of
+ *  its exchange (8 comparisons) instead of rescanning all exchanges. The
+ *  best bid or ask is only passed on when it changes, trades pass through.
+ *  Quotes of exchanges beyond the array are ignored, and counted.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "quote.h"
+#include "eventprocessor.h"
+
+class Nbbo : public EventProcessor
+{
+private:
+    /**
+     *  Number of exchanges, one for every possible exchange number
+     */
+    static constexpr size_t exchanges = 256;
+
+    /**
+     *  One side of the book, the quotes of every exchange and the tree
+     */
+    struct Side
+    {
+        /**
+         *  The last quote of every exchange
+         */
+        std::array<Quote, exchanges> quotes;
+
+        /**
+         *  The winner of every match, node 1 is the final, the children of
+         *  node n are 2n and 2n+1, and the nodes from 'exchanges' are the
+         *  exchanges themselves
+         */
+        std::array<uint8_t, exchanges> tree;
+
+        /**
+         *  The best quote that was passed on last
+         */
+        Quote best;
+
+        /**
+         *  Constructor, without any quotes the leftmost exchange wins every match
+         */
+        Side()
+        {
+            // fill the tree from the bottom up
+            for (size_t node = exchanges - 1; node > 0; node--) tree[node] = node * 2 >= exchanges ? static_cast<uint8_t>(node * 2 - exchanges) : tree[node * 2];
+        }
+    };
+
+    /**
+     *  The next processor (not owned)
+     */
+    EventProcessor *_next;
+
+    /**
+     *  Both sides
+     */
+    Side _bids;
+    Side _asks;
+
+    /**
+     *  Number of quotes, the number that changed the best bid or ask, and the number ignored
+     */
+    size_t _quotes = 0;
+    size_t _changes = 0;
+    size_t _ignored = 0;
+
+    /**
+     *  Whether a quote is better than another
+     *  @param  a
+     *  @param  b
+     *  @param  bid     whether these are bids (higher is better) or asks
+     *  @return bool
+     */
+    static bool better(const Quote &a, const Quote &b, bool bid)
+    {
+        // a missing quote is never better
+        if (!a.valid() || !b.valid()) return a.valid();
+
+        // the price decides first
+        if (a.price() != b.price()) return bid ? a.price() > b.price() : a.price() < b.price();
+
+        // then the size
+        return a.size() > b.size();
+    }
+
+    /**
+     *  The winner of a node
+     *  @param  side
+     *  @param  node
+     *  @return uint8_t
+     */
+    static uint8_t winner(const Side &side, size_t node)
+    {
+        // the leaves are the exchanges
+        return node >= exchanges ? static_cast<uint8_t>(node - exchanges) : side.tree[node];
+    }
+
+    /**
+     *  Update a side with a quote, and pass on the best if it changed
+     *  @param  side
+     *  @param  quote
+     *  @param  bid
+     *  @return bool    whether the best changed
+     */
+    bool update(Side &side, const Quote &quote, bool bid)
+    {
+        // an exchange we have no place for
+        if (quote.exchange() >= exchanges) { _ignored++; return false; }
+
+        // store the quote
+        side.quotes[quote.exchange()] = quote;
+
+        // replay the matches from the exchange up to the final, on ties the left one stays
+        for (size_t node = (exchanges + quote.exchange()) / 2; node > 0; node /= 2)
+        {
+            // the two contenders
+            uint8_t left = winner(side, node * 2);
+            uint8_t right = winner(side, node * 2 + 1);
+
+            // the better one goes through
+            side.tree[node] = better(side.quotes[right], side.quotes[left], bid) ? right : left;
+        }
+
+        // the best now
+        const Quote &best = side.quotes[side.tree[1]];
+
+        // statistics
+        _quotes++;
+
+        // nothing to pass on if it did not change
+        if (best.valid() == side.best.valid() && best.price() == side.best.price() && best.size() == side.best.size() && best.exchange() == side.best.exchange()) return false;
+
+        // it changed, at the time of this quote
+        side.best = Quote(quote.time(), best.price(), best.size(), best.exchange());
+        _changes++;
+        return true;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  next    the processor that gets the consolidated quotes
+     */
+    Nbbo(EventProcessor *next) : _next(next) {}
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override
+    {
+        // simply pass on
+        _next->onTrade(trade);
+    }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override
+    {
+        // pass on if the best bid changed
+        if (update(_bids, bid, true)) _next->onBid(_bids.best);
+    }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override
+    {
+        // pass on if the best ask changed
+        if (update(_asks, ask, false)) _next->onAsk(_asks.best);
+    }
+
+    /**
+     *  Process the passing of time
+     *  @param  time
+     */
+    virtual void onTime(size_t time) override
+    {
+        // simply pass on
+        _next->onTime(time);
+    }
+
+    /**
+     *  The current best bid and ask
+     *  @return Quote
+     */
+    const Quote &bid() const { return _bids.best; }
+    const Quote &ask() const { return _asks.best; }
+
+    /**
+     *  The last bid and ask of an exchange
+     *  @param  exchange
+     *  @return Quote
+     */
+    const Quote &bid(uint8_t exchange) const { return _bids.quotes[exchange]; }
+    const Quote &ask(uint8_t exchange) const { return _asks.quotes[exchange]; }
+
+    /**
+     *  Number of quotes, and the number that changed the best bid or ask
+     */
+    size_t quotes() const { return _quotes; }
+    size_t changes() const { return _changes; }
+
+    /**
+     *  Number of quotes that were ignored, because their exchange is out of range
+     */
+    size_t ignored() const { return _ignored; }
+};
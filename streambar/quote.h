@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 class Quote
 {
 private:
@@ -18,6 +21,11 @@ private:
      *  Quoted price (@todo decimal)
      */
     float _price = 0.0;
+
+    /**
+     *  Exchange it was quoted on, if known (fits in the padding after the price)
+     */
+    uint16_t _exchange = 0;
     
     /**
      *  Size of the quote
@@ -35,8 +43,9 @@ public:
      *  @param  time
      *  @param  price
      *  @param  size
+     *  @param  exchange
      */
-    Quote(size_t time, float price, size_t size) : _time(time), _price(price), _size(size) {}
+    Quote(size_t time, float price, size_t size, uint16_t exchange = 0) : _time(time), _price(price), _exchange(exchange), _size(size) {}
 
     /**
      *  Whether or not it is valid
@@ -61,4 +70,10 @@ public:
      *  @return size_t
      */
     size_t size() const { return _size; }
+
+    /**
+     *  Get the exchange
+     *  @return uint16_t
+     */
+    uint16_t exchange() const { return _exchange; }
 };
\ No newline at end of file
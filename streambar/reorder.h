@@ -0,0 +1,266 @@
+/**
+ *  Reorder.h
+ *
+ *  Puts events that arrive slightly out of order back in time order, before
+ *  passing them on to another event processor. An event is held until an
+ *  event arrives that is more than the window later, so the latency that
+ *  is added is at most the window. Events that arrive after events later
+ *  than them were already passed on can not be put back in order, they are
+ *  dropped and counted as late.
+ *
+ *  The held events are in a binary heap in an array that is allocated once,
+ *  so nothing is allocated per event. If the array is full, the earliest
+ *  event is passed on early (and counted), so the memory stays bounded.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "quote.h"
+#include "eventprocessor.h"
+#include "snapshot.h"
+
+class Reorder : public EventProcessor
+{
+private:
+    /**
+     *  A held event
+     */
+    struct Event
+    {
+        /**
+         *  Arrival order, to keep the order of events with the same time
+         */
+        uint64_t sequence;
+
+        /**
+         *  Record type and the quote
+         */
+        uint8_t type;
+        Quote quote;
+    };
+
+    /**
+     *  The next processor (not owned)
+     */
+    EventProcessor *_next;
+
+    /**
+     *  The window, in the unit of the times (milliseconds)
+     */
+    size_t _window;
+
+    /**
+     *  The heap of held events, with the earliest on top, and its capacity
+     */
+    std::vector<Event> _heap;
+    size_t _capacity;
+
+    /**
+     *  Arrival counter
+     */
+    uint64_t _sequence = 0;
+
+    /**
+     *  The latest time that was seen, and that was passed on
+     */
+    size_t _latest = 0;
+    size_t _passed = 0;
+
+    /**
+     *  Number of events that were late, and that were passed on early because the buffer was full
+     */
+    size_t _late = 0;
+    size_t _forced = 0;
+
+    /**
+     *  Ordering of the heap, the earliest event goes on top
+     *  @param  a
+     *  @param  b
+     *  @return bool
+     */
+    static bool later(const Event &a, const Event &b)
+    {
+        // on time first, and then on arrival
+        if (a.quote.time() != b.quote.time()) return a.quote.time() > b.quote.time();
+        return a.sequence > b.sequence;
+    }
+
+    /**
+     *  Pass on the earliest event
+     */
+    void pop()
+    {
+        // move it to the back
+        std::pop_heap(_heap.begin(), _heap.end(), later);
+
+        // the event
+        const Event &event = _heap.back();
+        _passed = event.quote.time();
+
+        // pass it on
+        switch (event.type) {
+        case 1:     _next->onTrade(event.quote); break;
+        case 2:     _next->onBid(event.quote); break;
+        case 3:     _next->onAsk(event.quote); break;
+        case 4:     _next->onTime(event.quote.time()); break;
+        }
+
+        // and remove it
+        _heap.pop_back();
+    }
+
+    /**
+     *  Add an event
+     *  @param  type
+     *  @param  quote
+     */
+    void add(uint8_t type, const Quote &quote)
+    {
+        // if a later event was already passed on, we're too late
+        if (quote.time() < _passed) { _late++; return; }
+
+        // if the buffer is full, the earliest has to go
+        if (_heap.size() == _capacity) { pop(); _forced++; }
+
+        // hold the event
+        _heap.push_back(Event{ _sequence++, type, quote });
+        std::push_heap(_heap.begin(), _heap.end(), later);
+
+        // the latest time seen
+        _latest = std::max(_latest, quote.time());
+
+        // pass on everything that is more than the window before it
+        while (!_heap.empty() && _heap.front().quote.time() + _window < _latest) pop();
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  next        the processor that gets the events in order
+     *  @param  window      how long an event is held (milliseconds)
+     *  @param  capacity    maximum number of held events
+     */
+    Reorder(EventProcessor *next, size_t window, size_t capacity = 4096) : _next(next), _window(window), _capacity(std::max<size_t>(capacity, 1))
+    {
+        // allocate the buffer once
+        _heap.reserve(_capacity);
+    }
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override { add(1, trade); }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override { add(2, bid); }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override { add(3, ask); }
+
+    /**
+     *  Process the passing of time, it is held like the other events
+     *  @param  time
+     */
+    virtual void onTime(size_t time) override { add(4, Quote(time, 0.0, 0)); }
+
+    /**
+     *  Pass on all held events, for example at the end of the input
+     */
+    void flush()
+    {
+        // pass on everything
+        while (!_heap.empty()) pop();
+    }
+
+    /**
+     *  Write the state, with the held events, to a snapshot
+     *  @param  snapshot
+     */
+    void save(Snapshot &snapshot) const
+    {
+        // the counters
+        snapshot.write(_sequence);
+        snapshot.write(_latest);
+        snapshot.write(_passed);
+        snapshot.write(_late);
+        snapshot.write(_forced);
+
+        // the held events, in the order of the heap
+        snapshot.write<uint64_t>(_heap.size());
+        for (const auto &event : _heap) snapshot.write(event);
+    }
+
+    /**
+     *  Read the state from a snapshot, the state is unchanged if it fails
+     *  @param  snapshot
+     *  @throws std::runtime_error
+     */
+    void load(Snapshot &snapshot)
+    {
+        // the counters, they are only ours once all is read
+        uint64_t sequence;
+        size_t latest, passed, late, forced;
+        snapshot.read(sequence);
+        snapshot.read(latest);
+        snapshot.read(passed);
+        snapshot.read(late);
+        snapshot.read(forced);
+
+        // the number of held events, they must fit
+        uint64_t size;
+        snapshot.read(size);
+        if (size > _capacity) throw std::runtime_error("snapshot holds more events than fit");
+
+        // the held events, they are still a heap
+        std::vector<Event> heap(size);
+        for (auto &event : heap) snapshot.read(event);
+
+        // everything was read
+        _sequence = sequence;
+        _latest = latest;
+        _passed = passed;
+        _late = late;
+        _forced = forced;
+        _heap = std::move(heap);
+
+        // the buffer is allocated once more, so it does not grow while it fills
+        _heap.reserve(_capacity);
+    }
+
+    /**
+     *  Number of held events
+     *  @return size_t
+     */
+    size_t size() const { return _heap.size(); }
+
+    /**
+     *  The window, in the unit of the times
+     *  @return size_t
+     */
+    size_t window() const { return _window; }
+
+    /**
+     *  Number of events that were dropped because they were late
+     *  @return size_t
+     */
+    size_t late() const { return _late; }
+
+    /**
+     *  Number of events that were passed on early because the buffer was full
+     *  @return size_t
+     */
+    size_t forced() const { return _forced; }
+};
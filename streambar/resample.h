@@ -0,0 +1,108 @@
+/**
+ *  Resample.h
+ *
+ *  Resamples a stream of bars into coarser ones, by merging the statistics
+ *  of the bars instead of going back to the trades. The bars are merged
+ *  either per number of bars, or per box of time (by the time of their
+ *  first trade). Bars with trades, accumulated bars and printed bars that
+ *  were read back can all be resampled.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include "bar.h"
+#include "accumulator.h"
+
+class Resample : public Bar::Handler, public Accumulator::Handler
+{
+public:
+    /**
+     *  How the bars are grouped
+     */
+    enum Mode { Count, Time };
+
+private:
+    /**
+     *  Where the coarser bars go (not owned)
+     */
+    Accumulator::Handler *_handler;
+
+    /**
+     *  Number of bars, or length of the boxes (in milliseconds)
+     */
+    size_t _size;
+    Mode _mode;
+
+    /**
+     *  The open bar, with the number of bars in it, and its box
+     */
+    Accumulator _bar;
+    size_t _count = 0;
+    size_t _box = 0;
+
+    /**
+     *  Emit the open bar
+     */
+    void emit()
+    {
+        // pass it on, and start a new one
+        _handler->onBar(_bar);
+        _bar = Accumulator();
+        _count = 0;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  handler     where the coarser bars go
+     *  @param  size        number of bars, or length of the boxes in milliseconds
+     *  @param  mode        whether the size is a count or a time
+     */
+    Resample(Accumulator::Handler *handler, size_t size, Mode mode = Count) : _handler(handler), _size(std::max<size_t>(size, 1)), _mode(mode) {}
+
+    /**
+     *  Called when a bar is done
+     *  @param  bar
+     */
+    virtual void onBar(const Accumulator &bar) override
+    {
+        // empty bars are ignored
+        if (bar.empty()) return;
+
+        // in time, the bar closes once the box changes
+        if (_mode == Time && _count > 0 && bar.first() / _size != _box) emit();
+
+        // merge it in
+        _bar.merge(bar);
+        _box = bar.first() / _size;
+
+        // in count, the bar closes once it is full
+        if (++_count == _size && _mode == Count) emit();
+    }
+
+    /**
+     *  Called when a bar with trades is done
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // the gaps and empty bars have nothing to merge
+        if (!bar || bar->size() == 0) return;
+
+        // merge its statistics
+        onBar(Accumulator(*bar));
+    }
+
+    /**
+     *  Emit the bar that is still open
+     */
+    void flush()
+    {
+        // only if there is one
+        if (_count > 0) emit();
+    }
+};
@@ -0,0 +1,104 @@
+/**
+ *  RingPublisher.h
+ *
+ *  Bar handler that publishes the bars into a ring in shared memory, as
+ *  fixed layout records, for strategies in other processes that read them
+ *  with a RingReader. Publishing is a copy and a few atomic stores, the
+ *  publisher never waits for the readers.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstring>
+#include "bar.h"
+#include "accumulator.h"
+#include "barrecord.h"
+#include "sharedring.h"
+
+class RingPublisher : public Bar::Handler, public Accumulator::Handler
+{
+private:
+    /**
+     *  The ring
+     */
+    SharedRing _ring;
+
+    /**
+     *  The symbol of the bars
+     */
+    std::string _symbol;
+
+    /**
+     *  Number of records published, only we write it
+     */
+    uint64_t _head = 0;
+
+public:
+    /**
+     *  Constructor, a ring with the same name is replaced
+     *  @param  name        the name of the shared memory, like "/bars"
+     *  @param  symbol      the symbol in the records
+     *  @param  capacity    number of records, rounded up to a power of two
+     *  @throws std::runtime_error
+     */
+    RingPublisher(const std::string &name, std::string symbol = "", size_t capacity = 4096) : _ring(name, capacity), _symbol(std::move(symbol)) {}
+
+    /**
+     *  Publish a record
+     *  @param  record
+     */
+    void publish(const BarRecord &record)
+    {
+        // the words of the record
+        uint64_t words[SharedRing::words];
+        memcpy(words, &record, sizeof(record));
+
+        // the slot is being written
+        SharedRing::Slot &slot = _ring.slot(_head);
+        slot.sequence.store(2 * _head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // write the record
+        for (size_t i = 0; i < SharedRing::words; i++) slot.record[i].store(words[i], std::memory_order_relaxed);
+
+        // the slot is complete, and so is the record
+        slot.sequence.store(2 * _head + 2, std::memory_order_release);
+        _ring.header()->head.store(++_head, std::memory_order_release);
+    }
+
+    /**
+     *  Called when a bar is done
+     *  @param  bar
+     */
+    virtual void onBar(const Accumulator &bar) override
+    {
+        // bars without trades are not published
+        if (bar.empty()) return;
+
+        // publish its record
+        publish(BarRecord::make(_symbol, bar));
+    }
+
+    /**
+     *  Called when a bar with trades is done
+     *  @param  bar
+     */
+    virtual void onBar(const std::shared_ptr<Bar> &bar) override
+    {
+        // the gaps and empty bars are not published
+        if (!bar || bar->size() == 0) return;
+
+        // publish its statistics
+        onBar(Accumulator(*bar));
+    }
+
+    /**
+     *  Number of records published
+     *  @return size_t
+     */
+    size_t published() const { return _head; }
+};
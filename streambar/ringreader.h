@@ -0,0 +1,117 @@
+/**
+ *  RingReader.h
+ *
+ *  Reads the bar records that a RingPublisher (in another process) puts in
+ *  a ring in shared memory. Reading does not make system calls, so it can
+ *  be polled in a busy loop. A reader that falls more than the capacity of
+ *  the ring behind skips the records that were overwritten, and counts
+ *  them as lost.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstring>
+#include "barrecord.h"
+#include "sharedring.h"
+
+class RingReader
+{
+private:
+    /**
+     *  The ring
+     */
+    SharedRing _ring;
+
+    /**
+     *  Number of the next record to read
+     */
+    uint64_t _next;
+
+    /**
+     *  Number of records that were overwritten before we read them
+     */
+    uint64_t _lost = 0;
+
+public:
+    /**
+     *  Constructor
+     *  @param  name        the name of the shared memory, like "/bars"
+     *  @param  history     whether to start at the oldest record still in the ring, instead of at the next one
+     *  @throws std::runtime_error
+     */
+    RingReader(const std::string &name, bool history = true) : _ring(name)
+    {
+        // where to start
+        uint64_t head = _ring.header()->head.load(std::memory_order_acquire);
+        _next = !history ? head : head > _ring.capacity() ? head - _ring.capacity() : 0;
+    }
+
+    /**
+     *  No copying
+     */
+    RingReader(const RingReader &that) = delete;
+
+    /**
+     *  Read the next record
+     *  @param  record
+     *  @return bool        false if there is no new record
+     */
+    bool read(BarRecord &record)
+    {
+        // until we read one, or there is none
+        while (true)
+        {
+            // is there a new one
+            uint64_t head = _ring.header()->head.load(std::memory_order_acquire);
+            if (_next >= head) return false;
+
+            // the ones that were overwritten are lost
+            if (head - _next > _ring.capacity()) { _lost += head - _ring.capacity() - _next; _next = head - _ring.capacity(); }
+
+            // the slot must hold our record, and be complete
+            SharedRing::Slot &slot = _ring.slot(_next);
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * _next + 2) { _lost++; _next++; continue; }
+
+            // copy the record
+            uint64_t words[SharedRing::words];
+            for (size_t i = 0; i < SharedRing::words; i++) words[i] = slot.record[i].load(std::memory_order_relaxed);
+
+            // it must not have been overwritten while we copied it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) { _lost++; _next++; continue; }
+
+            // we have it
+            memcpy(&record, words, sizeof(record));
+            _next++;
+            return true;
+        }
+    }
+
+    /**
+     *  Number of the next record to read
+     *  @return size_t
+     */
+    size_t position() const { return _next; }
+
+    /**
+     *  Number of records that were lost
+     *  @return size_t
+     */
+    size_t lost() const { return _lost; }
+
+    /**
+     *  Number of records that are waiting
+     *  @return size_t
+     */
+    size_t available() const
+    {
+        // the ones we did not read yet
+        uint64_t head = _ring.header()->head.load(std::memory_order_acquire);
+        return head > _next ? head - _next : 0;
+    }
+};
@@ -0,0 +1,205 @@
+/**
+ *  SharedRing.h
+ *
+ *  Ring of bar records in shared memory (/dev/shm), with a single writer and
+ *  any number of readers in other processes. Neither side makes a system
+ *  call or takes a lock once the ring is mapped.
+ *
+ *  Every slot is a seqlock: the writer makes the sequence of the slot odd
+ *  while it writes the record, and even again (two more than twice the
+ *  number of the record) once it is done. A reader that sees a different
+ *  sequence after copying the record knows it was overwritten. The writer
+ *  never waits for the readers, a reader that is more than the capacity
+ *  behind loses the oldest records.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "barrecord.h"
+
+class SharedRing
+{
+public:
+    /**
+     *  Identifies a ring, and the version of its layout
+     */
+    static constexpr uint64_t magic = 0x676e697262727473;
+    static constexpr uint32_t version = 1;
+
+    /**
+     *  Number of 8 byte words in a record
+     */
+    static constexpr size_t words = sizeof(BarRecord) / sizeof(uint64_t);
+
+    /**
+     *  The start of the ring
+     */
+    struct Header
+    {
+        /**
+         *  The magic, the version, the number of slots and the record size
+         */
+        uint64_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t record;
+        uint32_t reserved;
+
+        /**
+         *  Number of records published, on a cache line of its own
+         */
+        alignas(64) std::atomic<uint64_t> head;
+    };
+
+    /**
+     *  A slot, the record is stored as atomic words so that a reader may
+     *  copy it while it is being overwritten
+     */
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> record[words];
+    };
+
+private:
+    /**
+     *  The mapping
+     */
+    void *_memory = MAP_FAILED;
+    size_t _size = 0;
+
+    /**
+     *  Size of the ring for a capacity
+     *  @param  capacity
+     *  @return size_t
+     */
+    static size_t bytes(size_t capacity) { return sizeof(Header) + capacity * sizeof(Slot); }
+
+    /**
+     *  Map the file of the ring
+     *  @param  fd
+     *  @param  size
+     *  @param  writable
+     *  @param  name        for the error
+     *  @throws std::runtime_error
+     */
+    void map(int fd, size_t size, bool writable, const std::string &name)
+    {
+        // map it, the file is no longer needed after that
+        _memory = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        std::string error = strerror(errno);
+        close(fd);
+        if (_memory == MAP_FAILED) throw std::runtime_error("failed to map shared ring: " + name + ": " + error);
+        _size = size;
+    }
+
+    /**
+     *  Lock free atomics are needed to share them between processes
+     */
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs lock free 64 bit atomics");
+    static_assert(sizeof(BarRecord) % sizeof(uint64_t) == 0, "the record must be whole words");
+
+public:
+    /**
+     *  Constructor for the writer, a ring with the same name is replaced
+     *  @param  name        the name of the shared memory, like "/bars"
+     *  @param  capacity    number of records, rounded up to a power of two
+     *  @throws std::runtime_error
+     */
+    SharedRing(const std::string &name, size_t capacity)
+    {
+        // a power of two, so that the slot is a mask of the number
+        size_t slots = 1;
+        while (slots < capacity) slots *= 2;
+
+        // a new ring, readers of the old one keep their mapping of it
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("failed to create shared ring: " + name + ": " + std::string(strerror(errno)));
+
+        // it starts zeroed
+        if (ftruncate(fd, bytes(slots)) != 0) { std::string error = strerror(errno); close(fd); throw std::runtime_error("failed to size shared ring: " + name + ": " + error); }
+        map(fd, bytes(slots), true, name);
+
+        // the header, it is valid once the magic is there
+        Header *header = this->header();
+        header->version = version;
+        header->capacity = slots;
+        header->record = sizeof(BarRecord);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = magic;
+    }
+
+    /**
+     *  Constructor for a reader, the ring must exist
+     *  @param  name
+     *  @throws std::runtime_error
+     */
+    SharedRing(const std::string &name)
+    {
+        // open it
+        int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("failed to open shared ring: " + name + ": " + std::string(strerror(errno)));
+
+        // the size of the ring
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) { close(fd); throw std::runtime_error("not a shared ring: " + name); }
+        map(fd, info.st_size, false, name);
+
+        // check the header
+        const Header *header = this->header();
+        if (header->magic != magic || header->version != version || header->record != sizeof(BarRecord) || bytes(header->capacity) > _size) { munmap(_memory, _size); throw std::runtime_error("not a shared ring: " + name); }
+    }
+
+    /**
+     *  No copying
+     */
+    SharedRing(const SharedRing &that) = delete;
+
+    /**
+     *  Destructor
+     */
+    virtual ~SharedRing()
+    {
+        // unmap it, the ring stays until it is removed
+        munmap(_memory, _size);
+    }
+
+    /**
+     *  Remove a ring, the processes that mapped it keep it
+     *  @param  name
+     *  @return bool
+     */
+    static bool remove(const std::string &name) { return shm_unlink(name.c_str()) == 0; }
+
+    /**
+     *  The header
+     *  @return Header
+     */
+    Header *header() const { return static_cast<Header*>(_memory); }
+
+    /**
+     *  The slot of a record
+     *  @param  number
+     *  @return Slot
+     */
+    Slot &slot(uint64_t number) const { return reinterpret_cast<Slot*>(header() + 1)[number & (header()->capacity - 1)]; }
+
+    /**
+     *  Number of slots
+     *  @return size_t
+     */
+    size_t capacity() const { return header()->capacity; }
+};
@@ -2,15 +2,15 @@
 #pragma once
 
 #include "eventprocessor.h"
+#include "strategy.h"
 
 class Simulated : public EventProcessor
 {
 private:
     /**
-     *  Input stream
+     *  The strategy that is simulated
      */
-    std::istream &_input;
-    std::ostream &_output;
+    Strategy _strategy;
 
     /**
      *  Last bid/ask
@@ -18,46 +18,25 @@ private:
     Quote _ask;
     Quote _bid;
 
-    size_t _next = 0;
-    size_t _nextsize = 0;
-
-    size_t _bought = 0;
-
     /**
-     *  Helper method to process the next action
+     *  Helper method to process all actions before the given time, they
+     *  are executed against the bid/ask from before the update
+     *  @param  time
      */
-    void processAction()
+    void process(size_t time)
     {
-        // process the current line
-        _bought += _nextsize;
-
-        std::string line;
-
-        // parse the line
-        std::getline(_input, line);
-
-        // get the next and next size
-        _next = static_cast<int>(atof(line.c_str()) * 1000);
-        _nextsize = static_cast<int>(atoi(strchr(line.c_str(), ',') + 1));
+        // execute all actions that are due
+        while (time > _strategy.next()) _strategy.execute(_bid, _ask);
     }
 
 public:
-    Simulated(std::istream &input, std::ostream &output) : _input(input), _output(output) 
-    {
-        // take one line (header)
-        std::string line;
-        std::getline(_input, line);
-
-        // check the header
-        if (line != "timestamp,size") throw std::runtime_error("incorrect header");
-
-        // parse the line
-        std::getline(_input, line);
-
-        // get the next and next size
-        _next = static_cast<int>(atof(line.c_str()) * 1000);
-        _nextsize = static_cast<int>(atoi(strchr(line.c_str(), ',') + 1));
-    }
+    /**
+     *  Constructor
+     *  @param  input   the actions
+     *  @param  output  the records of the executed actions
+     *  @param  costs   the costs of trading
+     */
+    Simulated(std::istream &input, std::ostream &output, const Costs &costs = Costs()) : _strategy(input, output, costs) {}
 
     /**
      *  Process a trade
@@ -69,7 +48,7 @@ public:
     {
         // ignore for now, nothing to do here
     }
-    
+
     /**
      *  Process a bid
      *  @param  time
@@ -79,7 +58,7 @@ public:
     virtual void onBid(const Quote &bid) override
     {
         // before updating, we may need to process some actions
-        while (bid.time() > _next) processAction();
+        process(bid.time());
 
         // simply remember
         _bid = bid;
@@ -94,9 +73,30 @@ public:
     virtual void onAsk(const Quote &ask) override
     {
         // before update, we may need to process actions
-        while (ask.time() > _next) processAction();
+        process(ask.time());
 
         // simply remember
         _ask = ask;
     }
-};
\ No newline at end of file
+
+    /**
+     *  Execute the actions that are left after the market data, against the last bid/ask
+     */
+    void flush()
+    {
+        // execute everything
+        process(std::numeric_limits<size_t>::max());
+    }
+
+    /**
+     *  The strategy, with its account
+     *  @return Strategy
+     */
+    const Strategy &strategy() const { return _strategy; }
+
+    /**
+     *  Value of the strategy at the last bid/ask
+     *  @return double
+     */
+    double value() const { return _strategy.value(_bid, _ask); }
+};
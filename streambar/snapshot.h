@@ -0,0 +1,151 @@
+/**
+ *  Snapshot.h
+ *
+ *  Compact binary snapshot of the state of a BarMaker and its processor,
+ *  so that a process can be restarted without replaying the day. Values
+ *  are written as they are in memory, so a snapshot can only be loaded on
+ *  the same platform, by the same version of the library.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+class Snapshot
+{
+private:
+    /**
+     *  The bytes of the snapshot
+     */
+    std::string _data;
+
+    /**
+     *  Position we're reading at
+     */
+    size_t _position = 0;
+
+public:
+    /**
+     *  Constructor for an empty snapshot, to write to
+     */
+    Snapshot() = default;
+
+    /**
+     *  Constructor for an existing snapshot, to read from
+     *  @param  data
+     */
+    Snapshot(std::string data) : _data(std::move(data)) {}
+
+    /**
+     *  Write a value
+     *  @param  value
+     */
+    template <typename T>
+    void write(const T &value)
+    {
+        // only plain values can be written as they are
+        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be in a snapshot");
+
+        // append the bytes
+        _data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /**
+     *  Write a string, with its length
+     *  @param  value
+     */
+    void write(const std::string &value)
+    {
+        // the length, and the characters
+        write<uint64_t>(value.size());
+        _data.append(value);
+    }
+
+    /**
+     *  Read a value
+     *  @param  value
+     *  @throws std::runtime_error
+     */
+    template <typename T>
+    void read(T &value)
+    {
+        // only plain values can be read as they are
+        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be in a snapshot");
+
+        // it must be there
+        if (_position + sizeof(T) > _data.size()) throw std::runtime_error("snapshot is truncated");
+
+        // copy the bytes
+        memcpy(&value, _data.data() + _position, sizeof(T));
+        _position += sizeof(T);
+    }
+
+    /**
+     *  Read a string
+     *  @param  value
+     *  @throws std::runtime_error
+     */
+    void read(std::string &value)
+    {
+        // the length
+        uint64_t size;
+        read(size);
+
+        // the characters must be there
+        if (_position + size > _data.size()) throw std::runtime_error("snapshot is truncated");
+
+        // copy them
+        value.assign(_data, _position, size);
+        _position += size;
+    }
+
+    /**
+     *  The bytes of the snapshot
+     *  @return std::string
+     */
+    const std::string &data() const { return _data; }
+
+    /**
+     *  Save to a file
+     *  @param  name
+     *  @throws std::runtime_error
+     */
+    void save(const std::string &name) const
+    {
+        // open the file
+        std::ofstream out(name, std::ios::binary | std::ios::trunc);
+        if (!out.good()) throw std::runtime_error("failed to open snapshot file: " + name + ": " + std::string(strerror(errno)));
+
+        // write all bytes, and make sure they got there (the disk may be full)
+        out.write(_data.data(), _data.size());
+        out.close();
+        if (!out.good()) throw std::runtime_error("failed to write snapshot file: " + name + ": " + std::string(strerror(errno)));
+    }
+
+    /**
+     *  Load from a file
+     *  @param  name
+     *  @return Snapshot
+     *  @throws std::runtime_error
+     */
+    static Snapshot load(const std::string &name)
+    {
+        // open the file
+        std::ifstream in(name, std::ios::binary);
+        if (!in.good()) throw std::runtime_error("failed to open snapshot file: " + name + ": " + std::string(strerror(errno)));
+
+        // read all bytes
+        std::ostringstream data;
+        data << in.rdbuf();
+        return Snapshot(data.str());
+    }
+};
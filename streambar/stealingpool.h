@@ -0,0 +1,161 @@
+/**
+ *  StealingPool.h
+ *
+ *  Pool of worker threads for a known set of tasks of very different sizes.
+ *  The tasks are dealt round-robin over a deque per worker, in the order in
+ *  which they are given, so when they are given largest-first every worker
+ *  starts on its largest task. A worker takes from the front of its own
+ *  deque, and when that runs dry it steals from the back of the others, so
+ *  the small tasks fill up the tail instead of leaving cores idle. Tasks are
+ *  not allowed to throw, they should catch their own errors.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <memory>
+
+class StealingPool
+{
+public:
+    /**
+     *  A task gets the index of the worker that runs it
+     */
+    using Task = std::function<void(size_t worker)>;
+
+private:
+    /**
+     *  The deque of a single worker
+     */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     *  Number of threads
+     */
+    size_t _threads;
+
+    /**
+     *  Number of tasks that were stolen in the last run
+     */
+    size_t _stolen = 0;
+
+    /**
+     *  Take a task from the front of a queue
+     *  @param  queue
+     *  @param  task
+     *  @return bool
+     */
+    static bool take(Queue &queue, Task &task)
+    {
+        // lock the queue
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+
+        // take the first
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    /**
+     *  Steal a task from the back of a queue
+     *  @param  queue
+     *  @param  task
+     *  @return bool
+     */
+    static bool steal(Queue &queue, Task &task)
+    {
+        // lock the queue
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+
+        // take the last
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+public:
+    /**
+     *  Constructor
+     *  @param  threads     number of threads, 0 to use all cores
+     */
+    StealingPool(size_t threads = 0) : _threads(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads) {}
+
+    /**
+     *  Run all tasks, and wait until they are done
+     *  @param  tasks   the tasks, the largest first
+     */
+    void run(std::vector<Task> tasks)
+    {
+        // never more threads than tasks
+        size_t threads = std::max<size_t>(1, std::min(_threads, tasks.size()));
+
+        // deal the tasks over the queues
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (size_t i = 0; i < threads; i++) queues.emplace_back(new Queue());
+        for (size_t i = 0; i < tasks.size(); i++) queues[i % threads]->tasks.push_back(std::move(tasks[i]));
+
+        // number of stolen tasks, per worker
+        std::vector<size_t> stolen(threads, 0);
+
+        // the main loop of every worker
+        auto worker = [&queues, &stolen, threads](size_t index) {
+            // the task that we're running
+            Task task;
+
+            // keep going while there is work anywhere
+            while (true)
+            {
+                // first our own work
+                if (take(*queues[index], task)) { task(index); continue; }
+
+                // otherwise try the others, starting at our neighbour
+                bool found = false;
+                for (size_t i = 1; i < threads && !found; i++) found = steal(*queues[(index + i) % threads], task);
+
+                // nothing left anywhere, the queues only shrink
+                if (!found) return;
+
+                // run the stolen task
+                stolen[index]++;
+                task(index);
+            }
+        };
+
+        // start the threads, the calling thread is the first worker
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i++) workers.emplace_back(worker, i);
+        worker(0);
+
+        // wait for them
+        for (auto &thread : workers) thread.join();
+
+        // remember the number of stolen tasks
+        _stolen = 0;
+        for (auto count : stolen) _stolen += count;
+    }
+
+    /**
+     *  Number of threads in the pool
+     *  @return size_t
+     */
+    size_t size() const { return _threads; }
+
+    /**
+     *  Number of tasks that were stolen in the last run
+     *  @return size_t
+     */
+    size_t stolen() const { return _stolen; }
+};
@@ -0,0 +1,183 @@
+/**
+ *  Strategy.h
+ *
+ *  The actions of a single simulated strategy, and the account that they
+ *  are traded on. Actions are read from a file with a 'timestamp,size'
+ *  header, the timestamp in seconds in the day, a positive size to buy
+ *  and a negative size to sell. Every action is an immediate-or-cancel
+ *  order against the best bid/ask at that time, filling at most the size
+ *  that is quoted. For every action a record is written to the output.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include "quote.h"
+#include "costs.h"
+
+class Strategy
+{
+private:
+    /**
+     *  A single action
+     */
+    struct Action
+    {
+        /**
+         *  Time of the action, in milliseconds in the day
+         */
+        size_t time;
+
+        /**
+         *  Number of shares, positive to buy, negative to sell
+         */
+        long size;
+    };
+
+    /**
+     *  All actions, and the next one to execute
+     */
+    std::vector<Action> _actions;
+    size_t _current = 0;
+
+    /**
+     *  The output stream for the records
+     */
+    std::ostream &_output;
+
+    /**
+     *  The costs of trading
+     */
+    Costs _costs;
+
+    /**
+     *  Current position and cash
+     */
+    long _position = 0;
+    double _cash = 0.0;
+
+    /**
+     *  Total fees paid and shares traded
+     */
+    double _fees = 0.0;
+    size_t _traded = 0;
+
+public:
+    /**
+     *  Constructor, reads all the actions so that nothing is allocated while simulating
+     *  @param  input
+     *  @param  output
+     *  @param  costs
+     *  @throws std::runtime_error
+     */
+    Strategy(std::istream &input, std::ostream &output, const Costs &costs = Costs()) : _output(output), _costs(costs)
+    {
+        // take one line (header)
+        std::string line;
+        std::getline(input, line);
+
+        // check the header
+        if (line != "timestamp,size") throw std::runtime_error("incorrect header");
+
+        // read all the actions
+        while (std::getline(input, line))
+        {
+            // safety for empty lines
+            if (line.size() == 0) continue;
+
+            // find the size
+            const char *size = strchr(line.c_str(), ',');
+            if (size == nullptr) throw std::runtime_error("incorrect action: " + line);
+
+            // add the action
+            _actions.push_back(Action{ static_cast<size_t>(atof(line.c_str()) * 1000), atol(size + 1) });
+        }
+
+        // cash amounts need more than the default precision
+        _output.precision(12);
+
+        // write the header of the records
+        _output << "timestamp,requested,filled,price,fee,position,cash,value\n";
+    }
+
+    /**
+     *  No copying
+     */
+    Strategy(const Strategy &that) = delete;
+
+    /**
+     *  Time of the next action, or the maximum if there is none
+     *  @return size_t
+     */
+    size_t next() const { return _current < _actions.size() ? _actions[_current].time : std::numeric_limits<size_t>::max(); }
+
+    /**
+     *  Execute the next action, against the given bid and ask
+     *  @param  bid
+     *  @param  ask
+     */
+    void execute(const Quote &bid, const Quote &ask)
+    {
+        // the action to execute
+        const Action &action = _actions[_current++];
+
+        // buying takes the ask, selling the bid
+        bool buy = action.size > 0;
+        const Quote &quote = buy ? ask : bid;
+
+        // we fill as much as is quoted, but only if there is a market at all
+        size_t requested = std::labs(action.size);
+        size_t filled = bid.valid() && ask.valid() ? std::min(requested, quote.size()) : 0;
+
+        // the price including slippage, and the fee
+        double price = filled == 0 ? 0.0 : _costs.price(quote.price(), buy);
+        double fee = _costs.fee(filled);
+
+        // update the account
+        long shares = buy ? static_cast<long>(filled) : -static_cast<long>(filled);
+        _position += shares;
+        _cash -= shares * price + fee;
+        _fees += fee;
+        _traded += filled;
+
+        // write the record
+        _output << action.time << "," << action.size << "," << shares << "," << price << "," << fee << "," << _position << "," << _cash << "," << value(bid, ask) << "\n";
+    }
+
+    /**
+     *  Value of the account, the position is valued at the mid price
+     *  @param  bid
+     *  @param  ask
+     *  @return double
+     */
+    double value(const Quote &bid, const Quote &ask) const
+    {
+        // without a market, the position can not be valued
+        if (!bid.valid() || !ask.valid()) return _cash;
+
+        // value at the mid
+        return _cash + _position * (bid.price() + ask.price()) / 2.0;
+    }
+
+    /**
+     *  Number of actions
+     *  @return size_t
+     */
+    size_t actions() const { return _actions.size(); }
+
+    /**
+     *  Current position, cash, fees and total shares traded
+     */
+    long position() const { return _position; }
+    double cash() const { return _cash; }
+    double fees() const { return _fees; }
+    size_t traded() const { return _traded; }
+};
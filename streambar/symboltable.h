@@ -0,0 +1,182 @@
+/**
+ *  SymbolTable.h
+ *
+ *  Flat hash table from symbols to dense indices. The slots only hold the
+ *  hash and the index, and are probed linearly, so a lookup is a single
+ *  hash of the symbol and (almost always) a single cache line. The names
+ *  themselves are kept in a separate vector, ordered by index.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class SymbolTable
+{
+private:
+    /**
+     *  A single slot, the index is the maximum if it is empty
+     */
+    struct Slot
+    {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    /**
+     *  The slots, the number is always a power of two
+     */
+    std::vector<Slot> _slots;
+
+    /**
+     *  The names, by index
+     */
+    std::vector<std::string> _names;
+
+    /**
+     *  Index of an empty slot
+     */
+    static constexpr uint32_t empty = UINT32_MAX;
+
+    /**
+     *  Find the slot for a symbol, either the one with the symbol or the empty one where it belongs
+     *  @param  symbol
+     *  @param  size
+     *  @param  hash
+     *  @return size_t
+     */
+    size_t slot(const char *symbol, size_t size, uint32_t hash) const
+    {
+        // mask for the slots
+        size_t mask = _slots.size() - 1;
+
+        // probe linearly, there is always an empty slot
+        for (size_t i = hash & mask; true; i = (i + 1) & mask)
+        {
+            // the slot to check
+            const Slot &slot = _slots[i];
+
+            // an empty slot ends the search
+            if (slot.index == empty) return i;
+
+            // compare the hash first, only then the name
+            if (slot.hash == hash && _names[slot.index].compare(0, std::string::npos, symbol, size) == 0) return i;
+        }
+    }
+
+    /**
+     *  Double the number of slots, and put all indices back
+     */
+    void grow()
+    {
+        // the old slots
+        std::vector<Slot> slots(_slots.size() * 2, Slot{ 0, empty });
+        std::swap(slots, _slots);
+
+        // put them back in the new slots
+        for (const auto &slot : slots)
+        {
+            // skip the empty ones
+            if (slot.index == empty) continue;
+
+            // find the new place
+            _slots[this->slot(_names[slot.index].data(), _names[slot.index].size(), slot.hash)] = slot;
+        }
+    }
+
+public:
+    /**
+     *  Returned when a symbol is not found
+     */
+    static constexpr size_t npos = SIZE_MAX;
+
+    /**
+     *  Constructor
+     *  @param  capacity    initial number of slots, rounded up to a power of two
+     */
+    SymbolTable(size_t capacity = 64)
+    {
+        // round up to a power of two
+        size_t slots = 1;
+        while (slots < capacity) slots *= 2;
+
+        // all slots are empty
+        _slots.assign(slots, Slot{ 0, empty });
+    }
+
+    /**
+     *  Hash a symbol (FNV-1a)
+     *  @param  symbol
+     *  @param  size
+     *  @return uint32_t
+     */
+    static uint32_t hash(const char *symbol, size_t size)
+    {
+        // the offset basis
+        uint32_t result = 2166136261u;
+
+        // mix in every character
+        for (size_t i = 0; i < size; i++) result = (result ^ static_cast<uint8_t>(symbol[i])) * 16777619u;
+
+        // done
+        return result;
+    }
+
+    /**
+     *  Find the index of a symbol
+     *  @param  symbol
+     *  @param  size
+     *  @return size_t  the index, or npos
+     */
+    size_t find(const char *symbol, size_t size) const
+    {
+        // find the slot
+        const Slot &slot = _slots[this->slot(symbol, size, hash(symbol, size))];
+
+        // it may be empty
+        return slot.index == empty ? npos : slot.index;
+    }
+
+    /**
+     *  Find the index of a symbol, adding it if it is not there yet
+     *  @param  symbol
+     *  @param  size
+     *  @return size_t
+     */
+    size_t insert(const char *symbol, size_t size)
+    {
+        // the hash and the slot
+        uint32_t hash = SymbolTable::hash(symbol, size);
+        Slot &slot = _slots[this->slot(symbol, size, hash)];
+
+        // it might already be there
+        if (slot.index != empty) return slot.index;
+
+        // add it
+        slot = Slot{ hash, static_cast<uint32_t>(_names.size()) };
+        _names.emplace_back(symbol, size);
+
+        // keep the load below a half
+        if (_names.size() * 2 > _slots.size()) grow();
+
+        // the index of the new symbol
+        return _names.size() - 1;
+    }
+
+    /**
+     *  Number of symbols
+     *  @return size_t
+     */
+    size_t size() const { return _names.size(); }
+
+    /**
+     *  The name of a symbol
+     *  @param  index
+     *  @return std::string
+     */
+    const std::string &name(size_t index) const { return _names[index]; }
+};
@@ -0,0 +1,394 @@
+/**
+ *  TapeIndex.h
+ *
+ *  Sparse index from time to byte offset in a tape (or MML) file, so a
+ *  reader can seek straight to a time of day instead of parsing every line
+ *  before it. An entry is recorded for the first line at or after every
+ *  interval boundary. The index is built once and stored next to the tape
+ *  as '<tape>.idx'. Times in the file are expected to be non-decreasing.
+ *  The index remembers the size and modification time of the tape, and is
+ *  not used once the tape has changed.
+ *
+ *  Every entry also remembers where the bid and ask that were in effect at
+ *  that point are, so that a reader that seeks can first replay those, and
+ *  starts with the same market as a reader that parsed the whole file.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/stat.h>
+#include "util.h"
+
+class TapeIndex
+{
+public:
+    /**
+     *  Format of the indexed file
+     */
+    enum Format : uint8_t { Tape = 0, Mml = 1 };
+
+private:
+    /**
+     *  A single entry, time and the offset of the line, and the offsets of
+     *  the last bid and ask before it (or none)
+     */
+    struct Entry
+    {
+        uint64_t time;
+        uint64_t offset;
+        uint64_t bid;
+        uint64_t ask;
+    };
+
+    /**
+     *  Offset for a missing bid or ask
+     */
+    static constexpr uint64_t none = UINT64_MAX;
+
+    /**
+     *  The entries, ordered by time
+     */
+    std::vector<Entry> _entries;
+
+    /**
+     *  Format of the file
+     */
+    Format _format = Tape;
+
+    /**
+     *  Offset of the first line after the header
+     */
+    uint64_t _first = 0;
+
+    /**
+     *  Size and modification time (in nanoseconds) of the indexed file
+     */
+    uint64_t _size = 0;
+    uint64_t _modified = 0;
+
+    /**
+     *  Magic bytes at the start of the index file
+     */
+    static constexpr const char *magic() { return "SBIDX2"; }
+
+    /**
+     *  Size and modification time of a file
+     *  @param  file
+     *  @param  size
+     *  @param  modified
+     *  @return bool    whether the file exists
+     */
+    static bool stat(const std::string &file, uint64_t &size, uint64_t &modified)
+    {
+        // ask the file system
+        struct stat info;
+        if (::stat(file.c_str(), &info) != 0) return false;
+
+        // the size, and the time in nanoseconds
+        size = info.st_size;
+        modified = uint64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        return true;
+    }
+
+    /**
+     *  Parse a line
+     *  @param  line
+     *  @param  format
+     *  @param  quote
+     *  @param  filter  for the mml records
+     *  @return uint8_t the record type, or 0 if it is filtered out
+     */
+    static uint8_t parse(const char *line, Format format, Quote &quote, Filter &filter)
+    {
+        // parse in the right format
+        return format == Tape ? Util::parseTape(line, quote) : Util::parse(line, quote, filter);
+    }
+
+    /**
+     *  Replay the line at an offset
+     *  @param  stream
+     *  @param  offset
+     *  @param  maker
+     */
+    void replay(std::istream &stream, uint64_t offset, EventProcessor &maker) const
+    {
+        // nothing to replay
+        if (offset == none) return;
+
+        // the line at the offset
+        std::string line;
+        stream.seekg(offset);
+        std::getline(stream, line);
+
+        // parse it (it passed the filter when the index was built), and pass it on
+        Quote quote;
+        Filter filter = Filter::all();
+        Util::dispatch(maker, parse(line.c_str(), _format, quote, filter), quote, line.c_str());
+    }
+
+public:
+    /**
+     *  Constructor for an empty index
+     */
+    TapeIndex() = default;
+
+    /**
+     *  Build the index for a file
+     *  @param  stream      the file, positioned at the start
+     *  @param  format      format of the file
+     *  @param  interval    interval between the entries, in the unit of the file (milliseconds)
+     *  @param  filter      filter for the mml records, should be the one the file is read with
+     */
+    TapeIndex(std::istream &stream, Format format, size_t interval = 1000, Filter filter = Filter()) : _format(format)
+    {
+        // the line we're currently reading
+        std::string line;
+
+        // skip the first line
+        std::getline(stream, line);
+
+        // the offset of the current line
+        uint64_t offset = line.size() + 1;
+        _first = offset;
+
+        // the boundary of the next entry
+        uint64_t next = 0;
+
+        // the offsets of the last bid and ask
+        uint64_t bid = none;
+        uint64_t ask = none;
+
+        // the quote on the line
+        Quote quote;
+
+        // get a new line from the file
+        while (std::getline(stream, line))
+        {
+            // the offset of this line, and the next
+            uint64_t current = offset;
+            offset += line.size() + 1;
+
+            // safety for empty lines
+            if (line.size() == 0) continue;
+
+            // parse the line, the lines that are filtered out do not count
+            uint8_t type = parse(line.c_str(), format, quote, filter);
+            if (type == 0) continue;
+
+            // record an entry if we are at the next boundary
+            if (quote.time() >= next)
+            {
+                // record the entry
+                _entries.push_back(Entry{ quote.time(), current, bid, ask });
+
+                // the next boundary
+                next = (quote.time() / interval + 1) * interval;
+            }
+
+            // remember the last bid and ask
+            if (type == 2) bid = current;
+            if (type == 3) ask = current;
+        }
+    }
+
+    /**
+     *  Build the index for a file, that remembers the size and modification time of the file
+     *  @param  file        name of the file
+     *  @param  format      format of the file
+     *  @param  interval    interval between the entries, in the unit of the file (milliseconds)
+     *  @param  filter      filter for the mml records, should be the one the file is read with
+     *  @throws std::runtime_error
+     */
+    TapeIndex(const std::string &file, Format format, size_t interval = 1000, Filter filter = Filter())
+    {
+        // the file as it is before we read it
+        uint64_t size = 0, modified = 0;
+        if (!stat(file, size, modified)) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+        // open the file
+        std::ifstream stream(file);
+        if (!stream.good()) throw std::runtime_error("failed to open input file: " + std::string(strerror(errno)));
+
+        // build the index, and remember the file
+        *this = TapeIndex(stream, format, interval, std::move(filter));
+        _size = size;
+        _modified = modified;
+    }
+
+    /**
+     *  Load the index from a stream, the index is unchanged if it fails
+     *  @param  stream
+     *  @throws std::runtime_error
+     */
+    void load(std::istream &stream)
+    {
+        // read the magic
+        char header[6];
+        stream.read(header, sizeof(header));
+        if (!stream.good() || std::string(header, sizeof(header)) != magic()) throw std::runtime_error("invalid tape index");
+
+        // the index is read into a new one
+        TapeIndex result;
+        uint64_t count = 0;
+
+        // read the format, the first offset, the file and the number of entries
+        stream.read(reinterpret_cast<char*>(&result._format), sizeof(result._format));
+        stream.read(reinterpret_cast<char*>(&result._first), sizeof(result._first));
+        stream.read(reinterpret_cast<char*>(&result._size), sizeof(result._size));
+        stream.read(reinterpret_cast<char*>(&result._modified), sizeof(result._modified));
+        stream.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!stream.good()) throw std::runtime_error("truncated tape index");
+
+        // the format must be known
+        if (result._format != Tape && result._format != Mml) throw std::runtime_error("invalid tape index");
+
+        // the entries must all be there, before we make room for them
+        auto position = stream.tellg();
+        stream.seekg(0, std::ios::end);
+        auto end = stream.tellg();
+        stream.seekg(position);
+        if (position < 0 || end < position || count > uint64_t(end - position) / sizeof(Entry)) throw std::runtime_error("truncated tape index");
+
+        // read the entries
+        result._entries.resize(count);
+        stream.read(reinterpret_cast<char*>(result._entries.data()), count * sizeof(Entry));
+
+        // check that we got it all
+        if (!stream.good()) throw std::runtime_error("truncated tape index");
+
+        // only now the index changes
+        *this = std::move(result);
+    }
+
+    /**
+     *  Save the index to a stream
+     *  @param  stream
+     */
+    void save(std::ostream &stream) const
+    {
+        // the number of entries
+        uint64_t count = _entries.size();
+
+        // write the header
+        stream.write(magic(), 6);
+        stream.write(reinterpret_cast<const char*>(&_format), sizeof(_format));
+        stream.write(reinterpret_cast<const char*>(&_first), sizeof(_first));
+        stream.write(reinterpret_cast<const char*>(&_size), sizeof(_size));
+        stream.write(reinterpret_cast<const char*>(&_modified), sizeof(_modified));
+        stream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        // and the entries
+        stream.write(reinterpret_cast<const char*>(_entries.data()), count * sizeof(Entry));
+    }
+
+    /**
+     *  The entry from which all lines at or after the given time are found
+     *  @param  time
+     *  @return const Entry*    nullptr if we have to start at the beginning
+     */
+    const Entry *entry(size_t time) const
+    {
+        // find the first entry that is after the time
+        auto iter = std::upper_bound(_entries.begin(), _entries.end(), time, [](size_t time, const Entry &entry) { return time < entry.time; });
+
+        // if there is none before it, we have to start at the beginning
+        return iter == _entries.begin() ? nullptr : &*std::prev(iter);
+    }
+
+    /**
+     *  The offset from which all lines at or after the given time are found
+     *  @param  time
+     *  @return uint64_t
+     */
+    uint64_t offset(size_t time) const
+    {
+        // the entry to start from
+        const Entry *entry = this->entry(time);
+
+        // if there is none, we start after the header
+        return entry == nullptr ? _first : entry->offset;
+    }
+
+    /**
+     *  Seek a stream with the indexed file to the given time, the bid and
+     *  ask that are in effect at that point are first passed to the processor
+     *  @param  stream
+     *  @param  time
+     *  @param  maker
+     */
+    void seek(std::istream &stream, size_t time, EventProcessor &maker) const
+    {
+        // the entry to start from
+        const Entry *entry = this->entry(time);
+
+        // replay the market, if there is an entry
+        if (entry != nullptr) replay(stream, entry->bid, maker);
+        if (entry != nullptr) replay(stream, entry->ask, maker);
+
+        // seek to the offset
+        stream.seekg(offset(time));
+    }
+
+    /**
+     *  Whether the index is of a file as it is now, it is not if the file
+     *  was changed (or written again) after the index was built
+     *  @param  file
+     *  @return bool
+     */
+    bool matches(const std::string &file) const
+    {
+        // compare the size and the modification time
+        uint64_t size = 0, modified = 0;
+        return stat(file, size, modified) && size == _size && modified == _modified;
+    }
+
+    /**
+     *  Seek a stream to the given time, using the index stored next to the file, if there is one
+     *  @param  stream
+     *  @param  file    name of the file that is read by the stream
+     *  @param  time
+     *  @param  maker   processor that gets the bid and ask in effect at the time
+     *  @param  format  format the file is read in
+     *  @return bool    whether there was a matching index to seek with (a damaged one only costs speed)
+     */
+    static bool seek(std::istream &stream, const std::string &file, size_t time, EventProcessor &maker, Format format = Tape)
+    {
+        // open the index
+        std::ifstream in(file + ".idx", std::ios::binary);
+        if (!in.good()) return false;
+
+        // load it, a corrupt or truncated index is not used either
+        TapeIndex index;
+        try { index.load(in); } catch (const std::runtime_error &) { return false; }
+
+        // an index of another format, or of the file before it changed, is not used
+        if (index.format() != format || !index.matches(file)) return false;
+
+        // and seek
+        index.seek(stream, time, maker);
+        return true;
+    }
+
+    /**
+     *  Number of entries
+     *  @return size_t
+     */
+    size_t size() const { return _entries.size(); }
+
+    /**
+     *  Format of the indexed file
+     *  @return Format
+     */
+    Format format() const { return _format; }
+};
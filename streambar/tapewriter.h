@@ -0,0 +1,74 @@
+/**
+ *  TapeWriter.h
+ *
+ *  Event processor that writes every event to a tape, as it is.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <iostream>
+#include "quote.h"
+#include "eventprocessor.h"
+
+class TapeWriter : public EventProcessor
+{
+private:
+    /**
+     *  The output stream
+     */
+    std::ostream &_output;
+
+    /**
+     *  Number of events written
+     */
+    size_t _events = 0;
+
+    /**
+     *  Write an event
+     *  @param  type
+     *  @param  quote
+     */
+    void write(char type, const Quote &quote)
+    {
+        // output the line
+        _output << type << ',' << quote.time() << ',' << quote.price() << ',' << quote.size() << '\n';
+        _events++;
+    }
+
+public:
+    /**
+     *  Constructor, writes the header
+     *  @param  output
+     */
+    TapeWriter(std::ostream &output) : _output(output)
+    {
+        // write header to the output
+        _output << "event,time,price,size\n";
+    }
+
+    /**
+     *  Process a trade
+     *  @param  trade
+     */
+    virtual void onTrade(const Quote &trade) override { write('1', trade); }
+
+    /**
+     *  Process a bid
+     *  @param  bid
+     */
+    virtual void onBid(const Quote &bid) override { write('2', bid); }
+
+    /**
+     *  Process an ask
+     *  @param  ask
+     */
+    virtual void onAsk(const Quote &ask) override { write('3', ask); }
+
+    /**
+     *  Number of events written
+     *  @return size_t
+     */
+    size_t events() const { return _events; }
+};
@@ -6,9 +6,12 @@
 #include <memory>
 #include <vector>
 #include <limits.h>
+#include <cstdint>
 #include <cstring>
 #include <string>
 #include "eventprocessor.h"
+#include "filter.h"
+#include "instrument.h"
 
 class Util
 {
@@ -68,20 +71,139 @@ public:
     // }
 
     /**
-    *  Process function, also allows std::cin
+    *  Skip the header, but only if the stream is still at the start (and not
+    *  positioned in the middle of the file by a TapeIndex)
+    *  @param  stream
     */
-    static int process(EventProcessor &maker, std::istream &stream)
+    static void skipHeader(std::istream &stream)
     {
+        // the line with the header
+        std::string line;
+
+        // skip the first line (std::cin has no position, so also skip there)
+        if (stream.tellg() <= 0) std::getline(stream, line);
+    }
+
+    /**
+    *  Parse a line of an MML file into a quote
+    *  @param  line
+    *  @param  quote
+    *  @param  filter
+    *  @return uint8_t the record type, or 0 if the record is filtered out
+    */
+    static uint8_t parse(const char *line, Quote &quote, Filter &filter)
+    {
+        // time the parsing
+        Instrumentation::Probe probe(Instrumentation::Parse);
+
+        // find the record type
+        uint8_t type = line[0] - '0';
+
+        // find the exchange
+        const char *exchange = strchr(line + 2, ',');
+
+        // find 5th comma
+        const char *time = strchrn(line, ',', 5);
+        const char *price = strchr(time + 1, ',');
+        const char *size = strchr(price + 1, ',');
+        
+        // only certain trade conditions
+        const char *cond = strchr(size + 1, ',');
+
+        // parse the condition number
+        int numcond = atoi(cond + 1);
+
+        // number of the exchange
+        int numexc = atoi(exchange + 1);
+
+        // check the filter
+        if (!filter.accept(type, numcond, numexc)) return 0;
+
+        // construct the quote, exchanges that do not fit are unknown (and beyond every known one)
+        quote = Quote(offset(time), static_cast<float>(atof(price + 1)), atoi(size + 1), numexc >= 0 && numexc <= UINT16_MAX ? numexc : UINT16_MAX);
+
+        // the record type
+        return type;
+    }
+
+    /**
+    *  Parse a line of a tape into a quote
+    *  @param  line
+    *  @param  quote
+    *  @return uint8_t the record type
+    */
+    static uint8_t parseTape(const char *line, Quote &quote)
+    {
+        // time the parsing
+        Instrumentation::Probe probe(Instrumentation::Parse);
+
+        // element is the price, second comma, size is right after
+        const char *price = strchr(line + 2, ',');
+        const char *size = strchr(price + 1, ',');
+
+        // construct the quote, time is first element
+        quote = Quote(atoll(line + 2), static_cast<float>(atof(price + 1)), atof(size + 1));
+
+        // the record type
+        return line[0] - '0';
+    }
+
+    /**
+    *  Pass a parsed quote to the processor, type 4 is a heartbeat that only
+    *  carries the time
+    *  @param  maker
+    *  @param  type
+    *  @param  quote
+    *  @param  line    the line it was parsed from, for the error
+    */
+    static void dispatch(EventProcessor &maker, uint8_t type, const Quote &quote, const char *line)
+    {
+        // count the event
+        Instrumentation::count();
+
+        // switch over the type
+        switch (type) {
+        case 1:     maker.onTrade(quote); break;
+        case 2:     maker.onBid(quote); break;
+        case 3:     maker.onAsk(quote); break;
+        case 4:     maker.onTime(quote.time()); break;
+        default: 
+            // ignore, wrong type
+            std::cerr << "error while processing line: unknown recordtype: \n -> " << line << std::endl;
+        }
+    }
+
+    /**
+    *  Process function, also allows std::cin. Trades before the start are
+    *  skipped, but the bids and asks before it are still processed, so that
+    *  the first trades have a market to compare against.
+    *  @param  maker
+    *  @param  stream
+    *  @param  start   trades before this time are skipped
+    *  @param  end     processing stops after this time
+    *  @param  filter  filter for the records, the default one if not given
+    */
+    static int process(EventProcessor &maker, std::istream &stream, size_t start = 0, size_t end = SIZE_MAX, Filter *filter = nullptr)
+    {
+        // the default filter, if none was given
+        Filter fallback;
+        if (filter == nullptr) filter = &fallback;
+
+        // time the run
+        Instrumentation::Run run;
+
         // the line we're currently reading
         std::string line;
 
         // skip the first line
-        std::getline(stream, line);
+        skipHeader(stream);
 
-        // amount skipped
-        size_t skipped = 0;
+        // amount of rows
         size_t rows = 0;
 
+        // the quote on the line
+        Quote quote;
+
         // get a new line from the file
         while (std::getline(stream, line))
         {
@@ -91,46 +213,21 @@ public:
             // extra row!
             rows++;
 
-            // find the record type
-            uint8_t type = line[0] - '0';
+            // parse the line, it may be filtered out
+            uint8_t type = parse(line.c_str(), quote, *filter);
+            if (type == 0) continue;
 
-            // find the exchange
-            const char *exchange = strchr(line.c_str() + 2, ',');
+            // skip the trades before the start, and stop after the end
+            if (type == 1 && quote.time() < start) continue;
+            if (quote.time() > end) break;
 
-            // find 5th comma
-            const char *time = strchrn(line.c_str(), ',', 5);
-            const char *price = strchr(time + 1, ',');
-            const char *size = strchr(price + 1, ',');
-            
-            // only certain trade conditions
-            const char *cond = strchr(size + 1, ',');
-
-            // parse the condition number
-            int numcond = atoi(cond + 1);
-
-            // number of the exchange
-            int numexc = atoi(exchange + 1);
-
-            // parse the int, skip anything that is not 0, 95, or 115
-            if (numcond != 0 && numcond != 95 && numcond != 115) { skipped++; continue; }
-
-            // drop the dark pools
-            if (numexc != 0 && (numexc == 57 || numexc == 58 || numexc == 59)) { skipped++; continue; }
-
-            // construct the quote
-            Quote quote(offset(time), static_cast<float>(atof(price + 1)), atoi(size + 1));
-
-            // switch over the type
-            switch (type) {
-            case 1:     maker.onTrade(quote); break;
-            case 2:     maker.onBid(quote); break;
-            case 3:     maker.onAsk(quote); break;
-            default: 
-                // ignore, wrong type
-                std::cerr << "error while processing line: unknown recordtype: \n -> " << line << std::endl;
-            }
+            // pass it on
+            dispatch(maker, type, quote, line.c_str());
         }
 
+        // the number of records that were filtered out
+        size_t skipped = filter->dropped();
+
         if (skipped > 0) std::cout << "skipped " << skipped << " out of " << rows << " events while processing." << std::endl; 
 
         // always 0 for now
@@ -138,15 +235,26 @@ public:
     }
 
     /**
-     *  Process function, also allows std::cin
+     *  Process function, also allows std::cin. Trades before the start are
+     *  skipped, the bids and asks before it are still processed.
+     *  @param  maker
+     *  @param  stream
+     *  @param  start   trades before this time are skipped
+     *  @param  end     processing stops after this time
      */
-    static int processTape(EventProcessor &maker, std::istream &stream)
+    static int processTape(EventProcessor &maker, std::istream &stream, size_t start = 0, size_t end = SIZE_MAX)
     {
+        // time the run
+        Instrumentation::Run run;
+
         // the line we're currently reading
         std::string line;
 
         // skip the first line
-        std::getline(stream, line);
+        skipHeader(stream);
+
+        // the quote on the line
+        Quote quote;
 
         // get a new line from the file
         while (std::getline(stream, line))
@@ -154,31 +262,18 @@ public:
             // safety for empty lines
             if (line.size() == 0) continue;
             
-            // find the record type
-            uint8_t type = line[0] - '0';
-
-            // time is first element
-            size_t time = atoll(line.c_str() + 2);
-
-            // element is the price, second comma, size is right after
-            const char *price = strchr(line.c_str() + 2, ',');
-            const char *size = strchr(price + 1, ',');
-
-            // construct the quote
-            Quote quote(time, static_cast<float>(atof(price + 1)), atof(size + 1));
-
-            // switch over the type
-            switch (type) {
-            case 1:     maker.onTrade(quote); break;
-            case 2:     maker.onBid(quote); break;
-            case 3:     maker.onAsk(quote); break;
-            default: 
-                // ignore, wrong type
-                std::cerr << "error while processing line: unknown recordtype: \n -> " << line << std::endl;
-            }
+            // parse the line
+            uint8_t type = parseTape(line.c_str(), quote);
+
+            // skip the trades before the start, and stop after the end
+            if (type == 1 && quote.time() < start) continue;
+            if (quote.time() > end) break;
+
+            // pass it on
+            dispatch(maker, type, quote, line.c_str());
         }
 
         // always 0 for now
         return 0;
     }
-};
\ No newline at end of file
+};
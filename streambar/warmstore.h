@@ -0,0 +1,154 @@
+/**
+ *  WarmStore.h
+ *
+ *  Store of the state of processors at the end of a day, per symbol and
+ *  bar (type and parameters), so that the processors of the next day can
+ *  start from it. The imbalance and runs bars then do not have to converge
+ *  from the guesses in their constructors again, which otherwise takes a
+ *  replay of the days before.
+ *
+ *  The state is stored after the last bar of the day was completed, so the
+ *  open bar is not part of it, only the averages. The whole store is a
+ *  single file, that is replaced at once when it is saved.
+ *
+ *  @author Michael van der Werve
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include "snapshot.h"
+#include "barspec.h"
+#include "bars/processor.h"
+
+class WarmStore
+{
+private:
+    /**
+     *  The file of the store
+     */
+    std::string _path;
+
+    /**
+     *  The states, by symbol and the key of the bar
+     */
+    std::map<std::string, std::string> _states;
+
+    /**
+     *  The key of a symbol and a bar
+     *  @param  symbol
+     *  @param  spec
+     *  @return std::string
+     */
+    static std::string key(const std::string &symbol, const BarSpec &spec)
+    {
+        // the symbol, and then the bar
+        return symbol + '/' + spec.key();
+    }
+
+public:
+    /**
+     *  Constructor, reads the store if the file exists
+     *  @param  path
+     *  @throws std::runtime_error
+     */
+    WarmStore(std::string path) : _path(std::move(path))
+    {
+        // a new store if there is no file yet
+        if (!std::ifstream(_path).good()) return;
+
+        // read the snapshot
+        Snapshot snapshot = Snapshot::load(_path);
+
+        // check the format
+        uint32_t version;
+        snapshot.read(version);
+        if (version != 1) throw std::runtime_error("warm store has an unknown format: " + _path);
+
+        // read all the states
+        uint64_t count;
+        snapshot.read(count);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            // the key, and the state
+            std::string key;
+            snapshot.read(key);
+            snapshot.read(_states[key]);
+        }
+    }
+
+    /**
+     *  Start a processor from the stored state, if there is one
+     *  @param  symbol
+     *  @param  spec        the bar that the processor was created from
+     *  @param  processor
+     *  @return bool        whether there was a state
+     *  @throws std::runtime_error
+     */
+    bool warm(const std::string &symbol, const BarSpec &spec, Processor &processor) const
+    {
+        // find the state
+        auto iter = _states.find(key(symbol, spec));
+        if (iter == _states.end()) return false;
+
+        // load it into the processor
+        Snapshot snapshot(iter->second);
+        processor.load(snapshot);
+        return true;
+    }
+
+    /**
+     *  Store the state of a processor, it should be at the end of the day
+     *  (after the last bar was completed)
+     *  @param  symbol
+     *  @param  spec        the bar that the processor was created from
+     *  @param  processor
+     */
+    void put(const std::string &symbol, const BarSpec &spec, const Processor &processor)
+    {
+        // save the processor
+        Snapshot snapshot;
+        processor.save(snapshot);
+
+        // and store it
+        _states[key(symbol, spec)] = snapshot.data();
+    }
+
+    /**
+     *  Write the store to its file, it is replaced at once
+     *  @throws std::runtime_error
+     */
+    void save() const
+    {
+        // the format, and the number of states
+        Snapshot snapshot;
+        snapshot.write<uint32_t>(1);
+        snapshot.write<uint64_t>(_states.size());
+
+        // all the states
+        for (const auto &state : _states)
+        {
+            snapshot.write(state.first);
+            snapshot.write(state.second);
+        }
+
+        // write it next to the file, a file that was not completely written is not used
+        std::string temporary = _path + ".tmp";
+        try { snapshot.save(temporary); } catch (...) { std::remove(temporary.c_str()); throw; }
+
+        // and move it over the file
+        if (std::rename(temporary.c_str(), _path.c_str()) != 0) throw std::runtime_error("failed to replace warm store: " + _path + ": " + std::string(strerror(errno)));
+    }
+
+    /**
+     *  Number of stored states
+     *  @return size_t
+     */
+    size_t size() const { return _states.size(); }
+};